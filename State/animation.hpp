@@ -2,60 +2,73 @@
 #include <SFML/Graphics.hpp>
 #include <iostream>
 
-class Animation
+// sf::IntRect has no constexpr constructor, so clip tables use this instead.
+struct FrameRect
 {
-public:
-  enum class AnimationType
+  int left;
+  int top;
+  int width;
+  int height;
+};
+
+// Immutable description of an animation: its frames on the sprite sheet,
+// frames per second and what happens after the last frame. Clips are
+// defined once (see player_clips.hpp) and shared by every Animation.
+struct AnimationClip
+{
+  enum class Type
   {
     Repeat,
     OneIteration
   };
 
-  Animation(AnimationType type = AnimationType::Repeat) : mType{type} {}
-
-  void addTextureRect(sf::IntRect rect) { mTextureRects.push_back(rect); }
+  const FrameRect *frames;
+  int frameCount;
+  float speed;
+  Type type;
+};
 
-  void setAnimationSpeed(float animationSpeed)
-  {
-    mAnimationSpeed = animationSpeed;
-  }
+// Playhead over a clip: only the clip pointer and the current position.
+class Animation
+{
+public:
+  explicit Animation(const AnimationClip &clip) noexcept : mClip{&clip} {}
 
   sf::Vector2i getSize()
   {
-    return {mTextureRects[mCurrentFrame].width,
-            mTextureRects[mCurrentFrame].height};
+    const FrameRect &frame = mClip->frames[mCurrentFrame];
+    return {frame.width, frame.height};
   }
 
   void update(float dt)
   {
     mTime += dt;
-    mCurrentFrame = static_cast<int>(mAnimationSpeed * mTime);
+    mCurrentFrame = static_cast<int>(mClip->speed * mTime);
 
-    if (mCurrentFrame >= mTextureRects.size())
+    if (mCurrentFrame >= mClip->frameCount)
     {
-      if (mType == AnimationType::Repeat)
+      if (mClip->type == AnimationClip::Type::Repeat)
       {
         mCurrentFrame = 0;
         mTime = 0;
       }
-      else if (mType == AnimationType::OneIteration)
+      else if (mClip->type == AnimationClip::Type::OneIteration)
       {
-        mCurrentFrame = mTextureRects.size() - 1;
-        mTime = mCurrentFrame / mAnimationSpeed;
+        mCurrentFrame = mClip->frameCount - 1;
+        mTime = mCurrentFrame / mClip->speed;
       }
     }
   }
 
   void updateSprite(sf::Sprite &sprite)
   {
-    sprite.setTextureRect(mTextureRects[mCurrentFrame]);
+    const FrameRect &frame = mClip->frames[mCurrentFrame];
+    sprite.setTextureRect({frame.left, frame.top, frame.width, frame.height});
   }
 
 private:
-  std::vector<sf::IntRect> mTextureRects{};
+  const AnimationClip *mClip;
 
   int mCurrentFrame{0};
-  float mAnimationSpeed{1};
   float mTime{0};
-  AnimationType mType{AnimationType::OneIteration};
 };
@@ -0,0 +1,320 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Bounding volume hierarchy over the level's blocks, which never move once
+// the level is loaded. build() sorts the blocks into a binary tree of
+// bounding boxes, split at the median along the wider axis, so a query
+// visits O(log blocks) nodes instead of every block. Queries take a batch
+// and fill flat result arrays, so probing many points per tick does not
+// allocate once the arrays have grown.
+//
+// Touching counts as overlapping everywhere, as in
+// Player::handleCollision.
+class BlockBvh
+{
+public:
+  static constexpr std::uint32_t kNoBlock =
+      std::numeric_limits<std::uint32_t>::max();
+  static constexpr std::uint32_t kMaxLeafBlocks = 4;
+
+  // Segment from origin to origin + delta.
+  struct Ray
+  {
+    sf::Vector2f origin;
+    sf::Vector2f delta;
+  };
+
+  // A box moving by `motion`.
+  struct Sweep
+  {
+    sf::FloatRect box;
+    sf::Vector2f motion;
+  };
+
+  // First block a ray or sweep reaches, at `time` in [0, 1] along it, and
+  // the normal of the face it reaches ({0, 0} if it starts inside). block
+  // is kNoBlock, with time 1, if nothing is hit. Ties go to the lower
+  // block index.
+  struct Hit
+  {
+    std::uint32_t block;
+    float time;
+    sf::Vector2f normal;
+  };
+
+  void build(const std::vector<sf::FloatRect> &blocks)
+  {
+    mNodes.clear();
+    mBlocks.clear();
+    mIndices.resize(blocks.size());
+    for (std::uint32_t i = 0; i < mIndices.size(); ++i)
+      mIndices[i] = i;
+    if (blocks.empty())
+      return;
+
+    mNodes.reserve(2 * blocks.size() / kMaxLeafBlocks + 1);
+    buildNode(blocks, 0, static_cast<std::uint32_t>(blocks.size()));
+
+    // Leaves read their blocks from one contiguous run.
+    mBlocks.reserve(blocks.size());
+    for (std::uint32_t index : mIndices)
+      mBlocks.push_back(blocks[index]);
+  }
+
+  std::size_t size() const { return mBlocks.size(); }
+
+  // The indices of the blocks overlapping areas[i] end up in
+  // blocks[offsets[i]] to blocks[offsets[i + 1] - 1], ascending. Both
+  // vectors are replaced.
+  void overlap(const std::vector<sf::FloatRect> &areas,
+               std::vector<std::uint32_t> &blocks,
+               std::vector<std::uint32_t> &offsets) const
+  {
+    blocks.clear();
+    offsets.clear();
+    offsets.push_back(0);
+    for (const sf::FloatRect &area : areas)
+    {
+      std::size_t first = blocks.size();
+      overlapOne(area, blocks);
+      std::sort(blocks.begin() + first, blocks.end());
+      offsets.push_back(static_cast<std::uint32_t>(blocks.size()));
+    }
+  }
+
+  // hits[i] is replaced by the first hit of rays[i].
+  void castRays(const std::vector<Ray> &rays, std::vector<Hit> &hits) const
+  {
+    hits.resize(rays.size());
+    for (std::size_t i = 0; i < rays.size(); ++i)
+      hits[i] = sweepOne({rays[i].origin.x, rays[i].origin.y, 0, 0},
+                         rays[i].delta);
+  }
+
+  // hits[i] is replaced by the first hit of sweeps[i].
+  void sweep(const std::vector<Sweep> &sweeps, std::vector<Hit> &hits) const
+  {
+    hits.resize(sweeps.size());
+    for (std::size_t i = 0; i < sweeps.size(); ++i)
+      hits[i] = sweepOne(sweeps[i].box, sweeps[i].motion);
+  }
+
+private:
+  // Leaves hold `count` blocks starting at `start`. Inner nodes have a count
+  // of 0, their first child right after them and their second at `start`.
+  struct Node
+  {
+    float minX, minY, maxX, maxY;
+    std::uint32_t start;
+    std::uint32_t count;
+  };
+
+  // Deep enough for a median split tree over any uint32 count of blocks.
+  static constexpr int kMaxDepth = 64;
+
+  std::uint32_t buildNode(const std::vector<sf::FloatRect> &blocks,
+                          std::uint32_t begin, std::uint32_t end)
+  {
+    std::uint32_t index = static_cast<std::uint32_t>(mNodes.size());
+    Node node{std::numeric_limits<float>::max(),
+              std::numeric_limits<float>::max(),
+              std::numeric_limits<float>::lowest(),
+              std::numeric_limits<float>::lowest(), begin, end - begin};
+    float minCenterX = std::numeric_limits<float>::max();
+    float minCenterY = std::numeric_limits<float>::max();
+    float maxCenterX = std::numeric_limits<float>::lowest();
+    float maxCenterY = std::numeric_limits<float>::lowest();
+    for (std::uint32_t i = begin; i < end; ++i)
+    {
+      const sf::FloatRect &block = blocks[mIndices[i]];
+      node.minX = std::min(node.minX, block.left);
+      node.minY = std::min(node.minY, block.top);
+      node.maxX = std::max(node.maxX, block.left + block.width);
+      node.maxY = std::max(node.maxY, block.top + block.height);
+      minCenterX = std::min(minCenterX, block.left + block.width / 2);
+      minCenterY = std::min(minCenterY, block.top + block.height / 2);
+      maxCenterX = std::max(maxCenterX, block.left + block.width / 2);
+      maxCenterY = std::max(maxCenterY, block.top + block.height / 2);
+    }
+    mNodes.push_back(node);
+    if (end - begin <= kMaxLeafBlocks)
+      return index;
+
+    bool splitX = maxCenterX - minCenterX >= maxCenterY - minCenterY;
+    std::uint32_t middle = begin + (end - begin) / 2;
+    std::nth_element(mIndices.begin() + begin, mIndices.begin() + middle,
+                     mIndices.begin() + end,
+                     [&blocks, splitX](std::uint32_t a, std::uint32_t b) {
+                       const sf::FloatRect &first = blocks[a];
+                       const sf::FloatRect &second = blocks[b];
+                       return splitX ? first.left + first.width / 2 <
+                                           second.left + second.width / 2
+                                     : first.top + first.height / 2 <
+                                           second.top + second.height / 2;
+                     });
+
+    buildNode(blocks, begin, middle);
+    std::uint32_t second = buildNode(blocks, middle, end);
+    mNodes[index].start = second;
+    mNodes[index].count = 0;
+    return index;
+  }
+
+  void overlapOne(const sf::FloatRect &area,
+                  std::vector<std::uint32_t> &result) const
+  {
+    if (mNodes.empty())
+      return;
+
+    float right = area.left + area.width;
+    float bottom = area.top + area.height;
+    std::uint32_t stack[kMaxDepth];
+    int depth = 0;
+    stack[depth++] = 0;
+    while (depth > 0)
+    {
+      std::uint32_t index = stack[--depth];
+      const Node &node = mNodes[index];
+      if (node.minX > right || node.maxX < area.left || node.minY > bottom ||
+          node.maxY < area.top)
+        continue;
+
+      if (node.count == 0)
+      {
+        stack[depth++] = node.start;
+        stack[depth++] = index + 1;
+        continue;
+      }
+      for (std::uint32_t i = node.start; i < node.start + node.count; ++i)
+      {
+        const sf::FloatRect &block = mBlocks[i];
+        if (block.left <= right && block.left + block.width >= area.left &&
+            block.top <= bottom && block.top + block.height >= area.top)
+          result.push_back(mIndices[i]);
+      }
+    }
+  }
+
+  // Visits nodes nearest first and skips those the best hit so far is
+  // already ahead of.
+  Hit sweepOne(const sf::FloatRect &box, sf::Vector2f motion) const
+  {
+    Hit best{kNoBlock, 1, {0, 0}};
+    if (mNodes.empty())
+      return best;
+
+    struct Pending
+    {
+      std::uint32_t node;
+      float time;
+    };
+    Pending stack[kMaxDepth];
+    int depth = 0;
+    float time;
+    int axis;
+    if (entryTime(box, motion, mNodes[0], time, axis))
+      stack[depth++] = {0, time};
+
+    while (depth > 0)
+    {
+      Pending pending = stack[--depth];
+      if (pending.time > best.time)
+        continue;
+
+      const Node &node = mNodes[pending.node];
+      if (node.count == 0)
+      {
+        Pending children[2];
+        int found = 0;
+        for (std::uint32_t child : {pending.node + 1, node.start})
+          if (entryTime(box, motion, mNodes[child], time, axis))
+            children[found++] = {child, time};
+        if (found == 2 && children[0].time < children[1].time)
+          std::swap(children[0], children[1]);
+        for (int i = 0; i < found; ++i)
+          stack[depth++] = children[i];
+        continue;
+      }
+
+      for (std::uint32_t i = node.start; i < node.start + node.count; ++i)
+      {
+        const sf::FloatRect &block = mBlocks[i];
+        Node bounds{block.left, block.top, block.left + block.width,
+                    block.top + block.height, 0, 0};
+        if (!entryTime(box, motion, bounds, time, axis))
+          continue;
+        if (time < best.time ||
+            (time == best.time && mIndices[i] < best.block))
+        {
+          best.block = mIndices[i];
+          best.time = time;
+          best.normal = {0, 0};
+          if (axis == 0)
+            best.normal.x = motion.x > 0 ? -1.f : 1.f;
+          else if (axis == 1)
+            best.normal.y = motion.y > 0 ? -1.f : 1.f;
+        }
+      }
+    }
+    return best;
+  }
+
+  // Fraction of `motion` after which `box` first touches `bounds`, and the
+  // axis of the face it touches, or -1 if it touches from the start. False
+  // if it does not touch within the motion.
+  static bool entryTime(const sf::FloatRect &box, sf::Vector2f motion,
+                        const Node &bounds, float &time, int &axis)
+  {
+    float entryX, exitX, entryY, exitY;
+    if (!slab(box.left, box.left + box.width, motion.x, bounds.minX,
+              bounds.maxX, entryX, exitX) ||
+        !slab(box.top, box.top + box.height, motion.y, bounds.minY,
+              bounds.maxY, entryY, exitY))
+      return false;
+
+    float entry = std::max(entryX, entryY);
+    float exit = std::min(exitX, exitY);
+    if (entry > exit || entry > 1 || exit < 0)
+      return false;
+
+    if (entry <= 0)
+    {
+      time = 0;
+      axis = -1;
+    }
+    else
+    {
+      time = entry;
+      axis = entryX > entryY ? 0 : 1;
+    }
+    return true;
+  }
+
+  // Times at which a moving interval starts and stops overlapping [min,
+  // max]. Without motion it either always or never does.
+  static bool slab(float boxMin, float boxMax, float motion, float min,
+                   float max, float &entry, float &exit)
+  {
+    if (motion == 0)
+    {
+      entry = -std::numeric_limits<float>::infinity();
+      exit = std::numeric_limits<float>::infinity();
+      return boxMax >= min && max >= boxMin;
+    }
+    float first = (min - boxMax) / motion;
+    float second = (max - boxMin) / motion;
+    entry = std::min(first, second);
+    exit = std::max(first, second);
+    return true;
+  }
+
+  std::vector<Node> mNodes{};
+  // Blocks in leaf order, and the index each had in the level.
+  std::vector<sf::FloatRect> mBlocks{};
+  std::vector<std::uint32_t> mIndices{};
+};
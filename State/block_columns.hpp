@@ -0,0 +1,156 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX512F__) || defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Blocks stored as one float array per field, so that the overlap test can
+// check a run of blocks against one box per SIMD instruction: 16 with
+// AVX-512, 8 with AVX, 4 with SSE2 and one at a time otherwise. The widest
+// instruction set enabled at compile time (e.g. -mavx2) is used.
+class BlockColumns
+{
+public:
+  BlockColumns() = default;
+
+  explicit BlockColumns(const std::vector<sf::FloatRect> &blocks)
+  {
+    for (const sf::FloatRect &block : blocks)
+      push_back(block);
+  }
+
+  void push_back(const sf::FloatRect &block)
+  {
+    mLeft.push_back(block.left);
+    mTop.push_back(block.top);
+    mWidth.push_back(block.width);
+    mHeight.push_back(block.height);
+  }
+
+  // Replaces the contents with from[i] for each i in `indices`, in order.
+  void assign(const BlockColumns &from,
+              const std::vector<std::uint32_t> &indices)
+  {
+    mLeft.resize(indices.size());
+    mTop.resize(indices.size());
+    mWidth.resize(indices.size());
+    mHeight.resize(indices.size());
+    for (std::size_t i = 0; i < indices.size(); ++i)
+    {
+      mLeft[i] = from.mLeft[indices[i]];
+      mTop[i] = from.mTop[indices[i]];
+      mWidth[i] = from.mWidth[indices[i]];
+      mHeight[i] = from.mHeight[indices[i]];
+    }
+  }
+
+  std::size_t size() const { return mLeft.size(); }
+
+  sf::FloatRect operator[](std::size_t i) const
+  {
+    return {mLeft[i], mTop[i], mWidth[i], mHeight[i]};
+  }
+
+  // Index of the first block from `first` on that overlaps `box`, touching
+  // included, or size() if there is none. For finite coordinates a block is
+  // reported exactly when Player::handleCollision would find it overlapping
+  // the same box.
+  std::size_t firstOverlap(std::size_t first, const sf::FloatRect &box) const
+  {
+    float boxRight = box.left + box.width;
+    float boxBottom = box.top + box.height;
+    std::size_t i = first;
+    std::size_t n = size();
+
+#if defined(__AVX512F__)
+    __m512 boxLeft16 = _mm512_set1_ps(box.left);
+    __m512 boxTop16 = _mm512_set1_ps(box.top);
+    __m512 boxRight16 = _mm512_set1_ps(boxRight);
+    __m512 boxBottom16 = _mm512_set1_ps(boxBottom);
+    for (; i + 16 <= n; i += 16)
+    {
+      __m512 left = _mm512_loadu_ps(mLeft.data() + i);
+      __m512 top = _mm512_loadu_ps(mTop.data() + i);
+      __m512 right = _mm512_add_ps(left, _mm512_loadu_ps(mWidth.data() + i));
+      __m512 bottom = _mm512_add_ps(top, _mm512_loadu_ps(mHeight.data() + i));
+      __mmask16 hits = _mm512_cmp_ps_mask(left, boxRight16, _CMP_LE_OQ);
+      hits = _mm512_mask_cmp_ps_mask(hits, right, boxLeft16, _CMP_GE_OQ);
+      hits = _mm512_mask_cmp_ps_mask(hits, top, boxBottom16, _CMP_LE_OQ);
+      hits = _mm512_mask_cmp_ps_mask(hits, bottom, boxTop16, _CMP_GE_OQ);
+      if (hits != 0)
+        return i + lowestLane(hits);
+    }
+#elif defined(__AVX__)
+    __m256 boxLeft8 = _mm256_set1_ps(box.left);
+    __m256 boxTop8 = _mm256_set1_ps(box.top);
+    __m256 boxRight8 = _mm256_set1_ps(boxRight);
+    __m256 boxBottom8 = _mm256_set1_ps(boxBottom);
+    for (; i + 8 <= n; i += 8)
+    {
+      __m256 left = _mm256_loadu_ps(mLeft.data() + i);
+      __m256 top = _mm256_loadu_ps(mTop.data() + i);
+      __m256 right = _mm256_add_ps(left, _mm256_loadu_ps(mWidth.data() + i));
+      __m256 bottom = _mm256_add_ps(top, _mm256_loadu_ps(mHeight.data() + i));
+      __m256 hits = _mm256_and_ps(
+          _mm256_and_ps(_mm256_cmp_ps(left, boxRight8, _CMP_LE_OQ),
+                        _mm256_cmp_ps(right, boxLeft8, _CMP_GE_OQ)),
+          _mm256_and_ps(_mm256_cmp_ps(top, boxBottom8, _CMP_LE_OQ),
+                        _mm256_cmp_ps(bottom, boxTop8, _CMP_GE_OQ)));
+      unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(hits));
+      if (mask != 0)
+        return i + lowestLane(mask);
+    }
+#elif defined(__SSE2__)
+    __m128 boxLeft4 = _mm_set1_ps(box.left);
+    __m128 boxTop4 = _mm_set1_ps(box.top);
+    __m128 boxRight4 = _mm_set1_ps(boxRight);
+    __m128 boxBottom4 = _mm_set1_ps(boxBottom);
+    for (; i + 4 <= n; i += 4)
+    {
+      __m128 left = _mm_loadu_ps(mLeft.data() + i);
+      __m128 top = _mm_loadu_ps(mTop.data() + i);
+      __m128 right = _mm_add_ps(left, _mm_loadu_ps(mWidth.data() + i));
+      __m128 bottom = _mm_add_ps(top, _mm_loadu_ps(mHeight.data() + i));
+      __m128 hits =
+          _mm_and_ps(_mm_and_ps(_mm_cmple_ps(left, boxRight4),
+                                _mm_cmpge_ps(right, boxLeft4)),
+                     _mm_and_ps(_mm_cmple_ps(top, boxBottom4),
+                                _mm_cmpge_ps(bottom, boxTop4)));
+      unsigned mask = static_cast<unsigned>(_mm_movemask_ps(hits));
+      if (mask != 0)
+        return i + lowestLane(mask);
+    }
+#endif
+
+    for (; i < n; ++i)
+    {
+      if (mLeft[i] <= boxRight && mLeft[i] + mWidth[i] >= box.left &&
+          mTop[i] <= boxBottom && mTop[i] + mHeight[i] >= box.top)
+        return i;
+    }
+    return n;
+  }
+
+private:
+  static std::size_t lowestLane(unsigned mask)
+  {
+    std::size_t lane = 0;
+    while ((mask & 1) == 0)
+    {
+      mask >>= 1;
+      ++lane;
+    }
+    return lane;
+  }
+
+  std::vector<float> mLeft{};
+  std::vector<float> mTop{};
+  std::vector<float> mWidth{};
+  std::vector<float> mHeight{};
+};
@@ -0,0 +1,110 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Draws the level's blocks from vertex arrays that are only touched when a
+// block is added. Blocks are baked into chunks by the grid cell of their
+// top-left corner, and only chunks that reach into the visible area are
+// drawn, so the number of draw calls per frame depends on the view, not on
+// the size of the level. Blocks larger than a chunk, like the ground, get a
+// vertex array of their own and are culled one by one; a level has few.
+class BlockRenderer
+{
+public:
+  static constexpr float kChunkSize = 1024;
+
+  explicit BlockRenderer(sf::Color color) : mColor{color} {}
+
+  void add(const sf::FloatRect &block)
+  {
+    Chunk *chunk;
+    if (block.width > kChunkSize || block.height > kChunkSize)
+    {
+      mLargeBlocks.emplace_back();
+      chunk = &mLargeBlocks.back();
+      chunk->bounds = block;
+    }
+    else
+    {
+      auto inserted =
+          mChunks.try_emplace(key(cell(block.left), cell(block.top)));
+      chunk = &inserted.first->second;
+      if (inserted.second)
+      {
+        chunk->bounds = block;
+      }
+      else
+      {
+        float right = std::max(chunk->bounds.left + chunk->bounds.width,
+                               block.left + block.width);
+        float bottom = std::max(chunk->bounds.top + chunk->bounds.height,
+                                block.top + block.height);
+        chunk->bounds.left = std::min(chunk->bounds.left, block.left);
+        chunk->bounds.top = std::min(chunk->bounds.top, block.top);
+        chunk->bounds.width = right - chunk->bounds.left;
+        chunk->bounds.height = bottom - chunk->bounds.top;
+      }
+    }
+
+    // Two triangles per block.
+    sf::Vector2f topLeft{block.left, block.top};
+    sf::Vector2f topRight{block.left + block.width, block.top};
+    sf::Vector2f bottomLeft{block.left, block.top + block.height};
+    sf::Vector2f bottomRight{block.left + block.width,
+                             block.top + block.height};
+    for (sf::Vector2f corner :
+         {topLeft, topRight, bottomRight, topLeft, bottomRight, bottomLeft})
+      chunk->vertices.append(sf::Vertex(corner, mColor));
+  }
+
+  // Draws the chunks that may overlap `visible`, in world coordinates.
+  void draw(sf::RenderTarget &target, const sf::FloatRect &visible) const
+  {
+    // A chunk's blocks start inside its cell but may reach up to a cell
+    // further right or down, so the cells above and left of the view are
+    // checked too.
+    std::int32_t left = cell(visible.left) - 1;
+    std::int32_t top = cell(visible.top) - 1;
+    std::int32_t right = cell(visible.left + visible.width);
+    std::int32_t bottom = cell(visible.top + visible.height);
+    for (std::int32_t y = top; y <= bottom; ++y)
+    {
+      for (std::int32_t x = left; x <= right; ++x)
+      {
+        auto chunk = mChunks.find(key(x, y));
+        if (chunk != mChunks.end() && chunk->second.bounds.intersects(visible))
+          target.draw(chunk->second.vertices);
+      }
+    }
+
+    for (const Chunk &chunk : mLargeBlocks)
+      if (chunk.bounds.intersects(visible))
+        target.draw(chunk.vertices);
+  }
+
+private:
+  struct Chunk
+  {
+    sf::VertexArray vertices{sf::Triangles};
+    sf::FloatRect bounds{};
+  };
+
+  static std::int32_t cell(float coordinate)
+  {
+    return static_cast<std::int32_t>(std::floor(coordinate / kChunkSize));
+  }
+
+  static std::uint64_t key(std::int32_t x, std::int32_t y)
+  {
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32) |
+           static_cast<std::uint32_t>(y);
+  }
+
+  sf::Color mColor;
+  std::unordered_map<std::uint64_t, Chunk> mChunks{};
+  std::vector<Chunk> mLargeBlocks{};
+};
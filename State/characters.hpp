@@ -0,0 +1,312 @@
+#pragma once
+#include "job_system.hpp"
+#include "player_clips.hpp"
+#include "spatial_hash.hpp"
+#include "swept_motion.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+// Simple states of the characters other than the player.
+enum class CharacterState : std::uint8_t
+{
+  Standing,
+  Falling
+};
+
+// Crowd of computer-controlled characters in structure-of-arrays form: one
+// array per field, indexed by character. Each simulation pass walks only
+// the arrays it needs, front to back, so gravity and integration are plain
+// loops over floats that the compiler can vectorize. update() runs the
+// passes for slices of the crowd on several threads; characters only touch
+// their own slots, and state changes are applied afterwards in index order,
+// so the result is the same for any number of threads. All characters share
+// one texture and are drawn with one vertex array.
+//
+// integrate() moves characters freely; collide() then replays that move as
+// a sweep from the previous position, like Player::move, so fast falls stop
+// at thin blocks. Overlaps are resolved with the same rule as
+// Player::handleCollision without the hook. A character resting on top of a
+// block is Standing, any other is Falling.
+class Characters
+{
+public:
+  Characters()
+  {
+    if (!mTexture.loadFromFile("images/hero.png"))
+    {
+      std::cerr << "Can't load image /images/hero.png for Characters class"
+                << std::endl;
+      std::exit(1);
+    }
+  }
+
+  std::uint32_t add(sf::Vector2f position,
+                    sf::FloatRect collisionRect = {-40, -60, 80, 120})
+  {
+    mPositionX.push_back(position.x);
+    mPositionY.push_back(position.y);
+    mPreviousX.push_back(position.x);
+    mPreviousY.push_back(position.y);
+    mVelocityX.push_back(0);
+    mVelocityY.push_back(0);
+    mRectLeft.push_back(collisionRect.left);
+    mRectTop.push_back(collisionRect.top);
+    mRectWidth.push_back(collisionRect.width);
+    mRectHeight.push_back(collisionRect.height);
+    mStates.push_back(CharacterState::Falling);
+    mNextStates.push_back(CharacterState::Falling);
+    mAnimationTime.push_back(0);
+    return static_cast<std::uint32_t>(mPositionX.size() - 1);
+  }
+
+  std::size_t size() const { return mPositionX.size(); }
+
+  sf::Vector2f getPosition(std::uint32_t i) const
+  {
+    return {mPositionX[i], mPositionY[i]};
+  }
+
+  CharacterState getState(std::uint32_t i) const { return mStates[i]; }
+
+  // Gravity, integration and collision for the whole crowd, in slices of
+  // kSliceSize characters spread over the job system's threads.
+  void update(float gravity, float dt, const std::vector<sf::FloatRect> &blocks,
+              const SpatialHash &grid, JobSystem &jobs)
+  {
+    mCandidates.resize(jobs.getThreadCount());
+    jobs.parallelFor(size(), kSliceSize,
+                     [&](std::size_t begin, std::size_t end,
+                         std::size_t thread) {
+                       applyGravity(begin, end, gravity, dt);
+                       integrate(begin, end, dt);
+                       collide(begin, end, blocks, grid, mCandidates[thread]);
+                     });
+    applyTransitions();
+  }
+
+  void applyGravity(float gravity, float dt)
+  {
+    applyGravity(0, size(), gravity, dt);
+  }
+
+  // Keeps the previous positions for drawing and moves by velocity * dt.
+  void integrate(float dt) { integrate(0, size(), dt); }
+
+  // Sweeps every character's move since integrate() against the blocks near
+  // it and resolves the overlaps, in ascending block order like the player.
+  void collide(const std::vector<sf::FloatRect> &blocks,
+               const SpatialHash &grid)
+  {
+    mCandidates.resize(1);
+    collide(0, size(), blocks, grid, mCandidates[0]);
+    applyTransitions();
+  }
+
+  // Draws the characters whose center is within reach of `visible`, blended
+  // between the last two steps like Player::draw.
+  void draw(sf::RenderTarget &target, const sf::FloatRect &visible,
+            float alpha = 1)
+  {
+    mVertices.clear();
+    for (std::size_t i = 0; i < size(); ++i)
+    {
+      sf::Vector2f center{
+          mPreviousX[i] + (mPositionX[i] - mPreviousX[i]) * alpha,
+          mPreviousY[i] + (mPositionY[i] - mPreviousY[i]) * alpha};
+      if (center.x < visible.left - kCullMargin ||
+          center.x > visible.left + visible.width + kCullMargin ||
+          center.y < visible.top - kCullMargin ||
+          center.y > visible.top + visible.height + kCullMargin)
+        continue;
+
+      const AnimationClip &clip = getClip(clipOf(mStates[i]));
+      int frameIndex =
+          static_cast<int>(clip.speed * mAnimationTime[i]) % clip.frameCount;
+      const FrameRect &frame = clip.frames[frameIndex];
+      appendQuad(center, frame, mVelocityX[i] < 0);
+    }
+    target.draw(mVertices, &mTexture);
+  }
+
+private:
+  static constexpr std::size_t kSliceSize = 1024;
+  // As for Player::move.
+  static constexpr float kContactDepth = 1;
+  static constexpr int kMaxSweeps = 3;
+  static constexpr float kScale = 4;
+  // Larger than half of any frame at kScale.
+  static constexpr float kCullMargin = 100;
+
+  static constexpr PlayerClip clipOf(CharacterState state)
+  {
+    return state == CharacterState::Standing ? PlayerClip::Idle
+                                             : PlayerClip::Falling;
+  }
+
+  void applyGravity(std::size_t begin, std::size_t end, float gravity,
+                    float dt)
+  {
+    float *velocityY = mVelocityY.data();
+    float change = gravity * dt;
+    for (std::size_t i = begin; i < end; ++i)
+      velocityY[i] += change;
+  }
+
+  void integrate(std::size_t begin, std::size_t end, float dt)
+  {
+    std::copy(mPositionX.begin() + begin, mPositionX.begin() + end,
+              mPreviousX.begin() + begin);
+    std::copy(mPositionY.begin() + begin, mPositionY.begin() + end,
+              mPreviousY.begin() + begin);
+    integrateAxis(mPositionX.data(), mVelocityX.data(), begin, end, dt);
+    integrateAxis(mPositionY.data(), mVelocityY.data(), begin, end, dt);
+
+    float *animationTime = mAnimationTime.data();
+    for (std::size_t i = begin; i < end; ++i)
+      animationTime[i] += dt;
+  }
+
+  static void integrateAxis(float *position, const float *velocity,
+                            std::size_t begin, std::size_t end, float dt)
+  {
+    for (std::size_t i = begin; i < end; ++i)
+      position[i] += velocity[i] * dt;
+  }
+
+  // Only records the new states; applyTransitions() switches to them.
+  void collide(std::size_t begin, std::size_t end,
+               const std::vector<sf::FloatRect> &blocks,
+               const SpatialHash &grid, std::vector<std::uint32_t> &candidates)
+  {
+    for (std::size_t i = begin; i < end; ++i)
+    {
+      std::uint32_t character = static_cast<std::uint32_t>(i);
+      sf::Vector2f position{mPreviousX[i], mPreviousY[i]};
+      sf::Vector2f motion{mPositionX[i] - position.x,
+                          mPositionY[i] - position.y};
+      sf::FloatRect rect{mRectLeft[i], mRectTop[i], mRectWidth[i],
+                         mRectHeight[i]};
+      sf::FloatRect box{position.x + rect.left, position.y + rect.top,
+                        rect.width, rect.height};
+      grid.query(swept_motion::queryArea(
+                     swept_motion::sweptBounds(box, motion), box),
+                 candidates);
+      swept_motion::move(position, rect, motion, blocks, candidates,
+                         kContactDepth, kMaxSweeps);
+      mPositionX[i] = position.x;
+      mPositionY[i] = position.y;
+
+      bool onGround = false;
+      for (std::uint32_t index : candidates)
+        onGround |= resolve(character, blocks[index]);
+      mNextStates[i] =
+          onGround ? CharacterState::Standing : CharacterState::Falling;
+    }
+  }
+
+  void applyTransitions()
+  {
+    for (std::uint32_t i = 0; i < size(); ++i)
+      setState(i, mNextStates[i]);
+  }
+
+  sf::FloatRect getCollisionBounds(std::uint32_t i) const
+  {
+    return {mPositionX[i] + mRectLeft[i], mPositionY[i] + mRectTop[i],
+            mRectWidth[i], mRectHeight[i]};
+  }
+
+  void setState(std::uint32_t i, CharacterState state)
+  {
+    if (mStates[i] == state)
+      return;
+    mStates[i] = state;
+    mAnimationTime[i] = 0;
+  }
+
+  // Pushes character i out of `rect` along the axis of least overlap and
+  // returns whether it landed on top of it.
+  bool resolve(std::uint32_t i, const sf::FloatRect &rect)
+  {
+    sf::FloatRect box = getCollisionBounds(i);
+    float overlapx1 = box.left + box.width - rect.left;
+    float overlapx2 = rect.left + rect.width - box.left;
+    float overlapy1 = box.top + box.height - rect.top;
+    float overlapy2 = rect.top + rect.height - box.top;
+
+    if (overlapx1 < 0 || overlapx2 < 0 || overlapy1 < 0 || overlapy2 < 0)
+      return false;
+
+    float minOverlap = std::min(std::min(overlapx1, overlapx2),
+                                std::min(overlapy1, overlapy2));
+    if (minOverlap == overlapx1)
+    {
+      mPositionX[i] -= overlapx1 - 1;
+    }
+    else if (minOverlap == overlapx2)
+    {
+      mPositionX[i] += overlapx2 - 1;
+    }
+    else if (minOverlap == overlapy1)
+    {
+      mPositionY[i] -= overlapy1 - 1;
+      mVelocityY[i] = 0;
+      return true;
+    }
+    else
+    {
+      mPositionY[i] += overlapy2 - 1;
+      if (mVelocityY[i] < 0)
+        mVelocityY[i] = 0;
+    }
+    return false;
+  }
+
+  void appendQuad(sf::Vector2f center, const FrameRect &frame, bool mirrored)
+  {
+    float halfWidth = frame.width * kScale / 2;
+    float halfHeight = frame.height * kScale / 2;
+    float textureLeft = static_cast<float>(frame.left);
+    float textureRight = static_cast<float>(frame.left + frame.width);
+    if (mirrored)
+      std::swap(textureLeft, textureRight);
+    float textureTop = static_cast<float>(frame.top);
+    float textureBottom = static_cast<float>(frame.top + frame.height);
+
+    sf::Vertex topLeft{{center.x - halfWidth, center.y - halfHeight},
+                       {textureLeft, textureTop}};
+    sf::Vertex topRight{{center.x + halfWidth, center.y - halfHeight},
+                        {textureRight, textureTop}};
+    sf::Vertex bottomRight{{center.x + halfWidth, center.y + halfHeight},
+                           {textureRight, textureBottom}};
+    sf::Vertex bottomLeft{{center.x - halfWidth, center.y + halfHeight},
+                          {textureLeft, textureBottom}};
+    for (const sf::Vertex &vertex :
+         {topLeft, topRight, bottomRight, topLeft, bottomRight, bottomLeft})
+      mVertices.append(vertex);
+  }
+
+  std::vector<float> mPositionX{};
+  std::vector<float> mPositionY{};
+  std::vector<float> mPreviousX{};
+  std::vector<float> mPreviousY{};
+  std::vector<float> mVelocityX{};
+  std::vector<float> mVelocityY{};
+  // Collision rectangles relative to the position.
+  std::vector<float> mRectLeft{};
+  std::vector<float> mRectTop{};
+  std::vector<float> mRectWidth{};
+  std::vector<float> mRectHeight{};
+  std::vector<CharacterState> mStates{};
+  std::vector<CharacterState> mNextStates{};
+  std::vector<float> mAnimationTime{};
+
+  // Scratch for collision queries, one per job system thread.
+  std::vector<std::vector<std::uint32_t>> mCandidates{};
+  sf::VertexArray mVertices{sf::Triangles};
+  sf::Texture mTexture{};
+};
@@ -0,0 +1,184 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed pool of threads for splitting loops over many entities. The range
+// of a parallelFor is cut into pieces that are dealt out to per-thread
+// queues. Each thread takes pieces from the back of its own queue and, once
+// that is empty, steals from the front of the others, so a thread that hits
+// expensive entities does not hold up the rest. The calling thread works
+// too and counts as thread 0.
+class JobSystem
+{
+public:
+  static std::size_t defaultThreadCount()
+  {
+    return std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  explicit JobSystem(std::size_t threadCount = defaultThreadCount())
+      : mQueues(std::max<std::size_t>(threadCount, 1))
+  {
+    for (std::size_t i = 1; i < mQueues.size(); ++i)
+      mThreads.emplace_back([this, i] { workerLoop(i); });
+  }
+
+  JobSystem(const JobSystem &) = delete;
+  JobSystem &operator=(const JobSystem &) = delete;
+
+  ~JobSystem()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mWakeMutex);
+      mStopping = true;
+    }
+    mWake.notify_all();
+    for (std::thread &thread : mThreads)
+      thread.join();
+  }
+
+  std::size_t getThreadCount() const { return mQueues.size(); }
+
+  // Calls body(begin, end, thread) for consecutive ranges of at most `grain`
+  // indices that together cover [0, count), and returns once all of them
+  // have run. `thread` is below getThreadCount() and is never used by two
+  // ranges at the same time, so it can pick per-thread scratch data. The
+  // order in which ranges run is unspecified. body must not throw or call
+  // parallelFor itself.
+  template <typename Body>
+  void parallelFor(std::size_t count, std::size_t grain, Body &&body)
+  {
+    grain = std::max<std::size_t>(grain, 1);
+    std::size_t pieces = (count + grain - 1) / grain;
+    if (pieces <= 1 || mThreads.empty())
+    {
+      for (std::size_t begin = 0; begin < count; begin += grain)
+        body(begin, std::min(begin + grain, count), 0);
+      return;
+    }
+
+    using BodyType = std::remove_reference_t<Body>;
+    mBody = const_cast<void *>(static_cast<const void *>(&body));
+    mRun = [](void *context, std::size_t begin, std::size_t end,
+              std::size_t thread) {
+      (*static_cast<BodyType *>(context))(begin, end, thread);
+    };
+    mCount = count;
+    mGrain = grain;
+    mPending.store(pieces, std::memory_order_relaxed);
+
+    for (std::size_t piece = 0; piece < pieces; ++piece)
+    {
+      Queue &queue = mQueues[piece % mQueues.size()];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.pieces.push_back(piece);
+    }
+    {
+      std::lock_guard<std::mutex> lock(mWakeMutex);
+      ++mGeneration;
+    }
+    mWake.notify_all();
+
+    work(0);
+    std::unique_lock<std::mutex> lock(mDoneMutex);
+    mDone.wait(lock, [this] {
+      return mPending.load(std::memory_order_acquire) == 0;
+    });
+  }
+
+private:
+  // Indices of the pieces still to run. The owner pops from the back,
+  // thieves advance `head`.
+  struct Queue
+  {
+    std::mutex mutex;
+    std::vector<std::size_t> pieces;
+    std::size_t head{0};
+  };
+
+  void workerLoop(std::size_t thread)
+  {
+    std::uint64_t seen = 0;
+    while (true)
+    {
+      {
+        std::unique_lock<std::mutex> lock(mWakeMutex);
+        mWake.wait(lock, [&] { return mStopping || mGeneration != seen; });
+        if (mStopping)
+          return;
+        seen = mGeneration;
+      }
+      work(thread);
+    }
+  }
+
+  // Runs pieces until no queue has any left.
+  void work(std::size_t thread)
+  {
+    std::size_t piece;
+    while (take(thread, piece))
+    {
+      std::size_t begin = piece * mGrain;
+      mRun(mBody, begin, std::min(begin + mGrain, mCount), thread);
+      if (mPending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      {
+        std::lock_guard<std::mutex> lock(mDoneMutex);
+        mDone.notify_one();
+      }
+    }
+  }
+
+  bool take(std::size_t thread, std::size_t &piece)
+  {
+    for (std::size_t offset = 0; offset < mQueues.size(); ++offset)
+    {
+      Queue &queue = mQueues[(thread + offset) % mQueues.size()];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (queue.head == queue.pieces.size())
+        continue;
+
+      if (offset == 0)
+      {
+        piece = queue.pieces.back();
+        queue.pieces.pop_back();
+      }
+      else
+      {
+        piece = queue.pieces[queue.head++];
+      }
+      if (queue.head == queue.pieces.size())
+      {
+        queue.pieces.clear();
+        queue.head = 0;
+      }
+      return true;
+    }
+    return false;
+  }
+
+  std::vector<Queue> mQueues;
+  std::vector<std::thread> mThreads{};
+
+  // The loop being run. Written before its pieces are queued and only read
+  // by threads that took one of them.
+  void *mBody{nullptr};
+  void (*mRun)(void *, std::size_t, std::size_t, std::size_t){nullptr};
+  std::size_t mCount{0};
+  std::size_t mGrain{1};
+  std::atomic<std::size_t> mPending{0};
+
+  std::mutex mWakeMutex{};
+  std::condition_variable mWake{};
+  std::uint64_t mGeneration{0};
+  bool mStopping{false};
+
+  std::mutex mDoneMutex{};
+  std::condition_variable mDone{};
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include "world.hpp"
+#include <algorithm>
 
 int main()
 {
@@ -8,10 +9,14 @@ int main()
   sf::RenderWindow window(sf::VideoMode(1200, 900), "Player states",
                           sf::Style::Close, settings);
   window.setVerticalSyncEnabled(true);
-  window.setFramerateLimit(60);
 
+  // The simulation always advances in steps of dt, however fast frames are
+  // rendered. A slow frame runs several steps; a frame longer than
+  // kMaxFrameTime is cut short so the game slows down instead of spiralling.
   double time = 0;
-  double dt = 1.0 / 60;
+  const double dt = 1.0 / 60;
+  const double kMaxFrameTime = 0.25;
+  double accumulator = 0;
 
   World world;
   world.addBlock({-500, 770, 20000, 400});
@@ -29,6 +34,10 @@ int main()
 
   world.addBlock({3000, 500, 1000, 200});
 
+  for (int i = 0; i < 40; ++i)
+    world.addCharacter({-300.f + 100 * i, -1000});
+
+  sf::Clock clock;
   while (window.isOpen())
   {
     sf::Event event;
@@ -40,13 +49,22 @@ int main()
         window.close();
       world.handleEvents(event);
     }
+
+    accumulator += std::min<double>(clock.restart().asSeconds(), kMaxFrameTime);
+    while (accumulator >= dt)
+    {
+      world.update(dt);
+      time += dt;
+      accumulator -= dt;
+    }
+
+    // How far the next step has progressed, used to blend the last two.
+    float alpha = static_cast<float>(accumulator / dt);
+
     window.clear(sf::Color::Black);
-    world.update(dt);
-    world.draw(window);
+    world.draw(window, alpha);
 
     window.display();
-
-    time += dt;
   }
 
   return 0;
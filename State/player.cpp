@@ -1,10 +1,12 @@
 #pragma once
 #include "player.hpp"
 #include "player_states.hpp"
+#include "swept_motion.hpp"
 #include <cmath>
 #include <iostream>
 
-Player::Player(sf::Vector2f position) : mPosition{position}
+Player::Player(sf::Vector2f position)
+    : mPosition{position}, mPreviousPosition{position}
 {
   if (!mTexture.loadFromFile("images/hero.png"))
   {
@@ -13,8 +15,6 @@ Player::Player(sf::Vector2f position) : mPosition{position}
     std::exit(1);
   }
 
-  setState(new Idle(this));
-
   mSprite.setTexture(mTexture);
   mSprite.setOrigin(mSprite.getLocalBounds().width / 2,
                     mSprite.getLocalBounds().height / 2);
@@ -24,29 +24,49 @@ Player::Player(sf::Vector2f position) : mPosition{position}
   mSprite.setScale(mScaleFactor, mScaleFactor);
 }
 
-void Player::setState(PlayerState *pNewState)
+PlayerState &Player::state()
 {
-  delete mpState;
-  mpState = pNewState;
+  return std::visit([](PlayerState &state) -> PlayerState & { return state; },
+                    mState);
 }
 
 sf::Vector2f Player::getCenter() const { return mPosition; }
 
+sf::FloatRect Player::getCollisionBounds() const
+{
+  return {mPosition.x + mCollisionRect.left, mPosition.y + mCollisionRect.top,
+          mCollisionRect.width, mCollisionRect.height};
+}
+
 void Player::applyVelocity(sf::Vector2f velocity) { mVelocity += velocity; }
 
 void Player::update(float dt)
 {
-  mpState->update(this, dt);
-  mPosition += mVelocity * dt;
+  mPreviousPosition = mPosition;
+  std::visit([this, dt](auto &state) { state.update(this, dt); }, mState);
+  mMotion = mVelocity * dt;
+}
 
-  mSprite.setOrigin(mSprite.getLocalBounds().width / 2,
-                    mSprite.getLocalBounds().height / 2);
-  mSprite.setPosition(mPosition);
+sf::FloatRect Player::getSweptBounds() const
+{
+  return swept_motion::sweptBounds(getCollisionBounds(), mMotion);
+}
+
+void Player::move(const std::vector<sf::FloatRect> &blocks,
+                  const std::vector<std::uint32_t> &candidates)
+{
+  swept_motion::move(mPosition, mCollisionRect, mMotion, blocks, candidates,
+                     kContactDepth, kMaxSweeps);
+  mMotion = {0, 0};
 }
 
-void Player::draw(sf::RenderWindow &window)
+void Player::draw(sf::RenderWindow &window, float alpha)
 {
-  mpState->setSprite(mSprite, mIsFacedRight);
+  state().setSprite(mSprite, mIsFacedRight);
+  mSprite.setOrigin(mSprite.getLocalBounds().width / 2,
+                    mSprite.getLocalBounds().height / 2);
+  mSprite.setPosition(mPreviousPosition +
+                      (mPosition - mPreviousPosition) * alpha);
   window.draw(mSprite);
 
   if (false) // For debuging
@@ -67,7 +87,8 @@ void Player::draw(sf::RenderWindow &window)
 
 void Player::handleEvents(const sf::Event &event)
 {
-  mpState->handleEvents(this, event);
+  std::visit([this, &event](auto &state) { state.handleEvents(this, event); },
+             mState);
 }
 
 bool Player::handleCollision(const sf::FloatRect &rect)
@@ -109,7 +130,7 @@ bool Player::handleCollision(const sf::FloatRect &rect)
     if (mVelocity.y > 0 && playerRect.top < rect.top + Hooked::kMaxHookOffset &&
         playerRect.top > rect.top - Hooked::kMaxHookOffset)
     {
-      mpState->hook(this);
+      dispatch<HookEvent>();
     }
     break;
   case 1:
@@ -117,14 +138,14 @@ bool Player::handleCollision(const sf::FloatRect &rect)
     if (mVelocity.y > 0 && playerRect.top < rect.top + Hooked::kMaxHookOffset &&
         playerRect.top > rect.top - Hooked::kMaxHookOffset)
     {
-      mpState->hook(this);
+      dispatch<HookEvent>();
     }
     break;
   case 2:
     mPosition.y -= overlapy1 - 1;
     mVelocity.y = 0;
     mVelocity.y = 0;
-    mpState->hitGround(this);
+    dispatch<HitGroundEvent>();
     break;
   case 3:
     mPosition.y += overlapy2 - 1;
@@ -149,7 +170,35 @@ void Player::handleAllCollisions(const std::vector<sf::FloatRect> &blocks)
   }
 
   if (!mIsColliding)
-    mpState->startFalling(this);
+    dispatch<StartFallingEvent>();
+}
+
+void Player::handleAllCollisions(const std::vector<sf::FloatRect> &blocks,
+                                 const std::vector<std::uint32_t> &candidates)
+{
+  mIsColliding = false;
+
+  for (std::uint32_t index : candidates)
+  {
+    if (handleCollision(blocks[index]))
+      mIsColliding = true;
+  }
+
+  if (!mIsColliding)
+    dispatch<StartFallingEvent>();
 }
 
-Player::~Player() { delete mpState; }
\ No newline at end of file
+void Player::handleAllCollisions(const BlockColumns &blocks)
+{
+  mIsColliding = false;
+
+  for (std::size_t i = blocks.firstOverlap(0, getCollisionBounds());
+       i < blocks.size(); i = blocks.firstOverlap(i + 1, getCollisionBounds()))
+  {
+    if (handleCollision(blocks[i]))
+      mIsColliding = true;
+  }
+
+  if (!mIsColliding)
+    dispatch<StartFallingEvent>();
+}
\ No newline at end of file
@@ -1,7 +1,7 @@
 #pragma once
+#include "block_columns.hpp"
 #include "player_states.hpp"
-
-class PlayerState;
+#include <cstdint>
 
 class Player
 {
@@ -9,15 +9,31 @@ public:
   Player(sf::Vector2f position);
 
   sf::Vector2f getCenter() const;
+  sf::FloatRect getCollisionBounds() const;
   void applyVelocity(sf::Vector2f velocity);
 
+  // Runs the state logic and works out this step's motion, which move()
+  // then applies.
   void update(float dt);
-  void draw(sf::RenderWindow &window);
+  // Bounds covering the player both before and after the pending motion.
+  sf::FloatRect getSweptBounds() const;
+  // Moves by the pending motion, but stops at the first face of a candidate
+  // block that the player would pass into, then keeps sliding along it.
+  // Fast movement therefore cannot skip thin blocks at any tick rate.
+  void move(const std::vector<sf::FloatRect> &blocks,
+            const std::vector<std::uint32_t> &candidates);
+  // alpha in [0, 1] blends the previous step (0) with the current one (1).
+  void draw(sf::RenderWindow &window, float alpha = 1);
   void handleEvents(const sf::Event &event);
   bool handleCollision(const sf::FloatRect &rect);
   void handleAllCollisions(const std::vector<sf::FloatRect> &blocks);
-
-  ~Player();
+  // Same, but only tests blocks[i] for the indices in `candidates`, which
+  // must be ascending so blocks are resolved in the usual order.
+  void handleAllCollisions(const std::vector<sf::FloatRect> &blocks,
+                           const std::vector<std::uint32_t> &candidates);
+  // Same as the full scan, but finds the overlapping blocks with SIMD. Each
+  // hit is resolved before looking further, as in the scalar loop.
+  void handleAllCollisions(const BlockColumns &blocks);
 
   friend class PlayerState;
   friend class Idle;
@@ -29,16 +45,43 @@ public:
 
 private:
   sf::Vector2f mPosition{0, 0};
+  sf::Vector2f mPreviousPosition{0, 0};
   sf::Vector2f mVelocity{0, 0};
+  sf::Vector2f mMotion{0, 0};
 
   bool mIsColliding{false};
   sf::FloatRect mCollisionRect{-40, -60, 80, 120};
+  // A blocked move ends this far inside the face it hit, which is where
+  // handleCollision leaves a player at rest against a block.
+  static constexpr float kContactDepth = 1;
+  static constexpr int kMaxSweeps = 3;
 
-  PlayerState *mpState{nullptr};
+  // Every state lives in place, so a transition never allocates.
+  PlayerStates mState{std::in_place_type<Idle>, this};
   sf::Texture mTexture{};
   sf::Sprite mSprite{};
   float mScaleFactor{1};
   bool mIsFacedRight{true};
 
-  void setState(PlayerState *pNewState);
+  PlayerState &state();
+
+  // Replaces the current state. When called from a state's own method, that
+  // state is destroyed on the spot, so the method must not touch its
+  // members afterwards. State constructors are noexcept; otherwise emplace
+  // would build the state in a temporary variant and copy it over.
+  template <typename State> void setState() { mState.emplace<State>(this); }
+
+  // Applies the current state's entry of the transition table for Event.
+  // Entries that stay put generate no code.
+  template <typename Event> void dispatch()
+  {
+    std::visit(
+        [this](auto &state) {
+          using State = std::decay_t<decltype(state)>;
+          using Target = TransitionTarget<State, Event>;
+          if constexpr (!std::is_same<Target, Stay>::value)
+            setState<Target>();
+        },
+        mState);
+  }
 };
@@ -0,0 +1,76 @@
+#pragma once
+#include "animation.hpp"
+#include <array>
+#include <cstddef>
+
+// Clips of images/hero.png, indexed by PlayerClip.
+enum class PlayerClip
+{
+  Idle,
+  Running,
+  Sliding,
+  Falling,
+  Hooked,
+  Sitting,
+  Count
+};
+
+namespace player_clips
+{
+constexpr FrameRect kIdle[] = {
+    {14, 6, 21, 30}, {64, 6, 21, 30}, {114, 6, 21, 30}, {164, 6, 21, 30}};
+
+constexpr FrameRect kRunning[] = {{67, 45, 20, 27},  {116, 46, 20, 27},
+                                  {166, 48, 20, 27}, {217, 45, 20, 27},
+                                  {266, 46, 20, 27}, {316, 48, 20, 27}};
+
+constexpr FrameRect kSliding[] = {{155, 119, 34, 28},
+                                  {205, 119, 34, 28},
+                                  {255, 119, 34, 28},
+                                  {307, 119, 34, 28},
+                                  {9, 156, 34, 28}};
+
+constexpr FrameRect kFalling[] = {{321, 155, 15, 26}};
+
+constexpr FrameRect kHooked[] = {{70, 151, 16, 34},
+                                 {119, 151, 16, 34},
+                                 {169, 151, 16, 34},
+                                 {219, 151, 16, 34}};
+
+constexpr FrameRect kSitting[] = {
+    {214, 6, 21, 30}, {264, 6, 21, 30}, {314, 6, 21, 30}, {14, 43, 21, 30}};
+
+template <std::size_t N>
+constexpr AnimationClip makeClip(const FrameRect (&frames)[N], float speed,
+                                 AnimationClip::Type type)
+{
+  return {frames, static_cast<int>(N), speed, type};
+}
+
+// Same order as PlayerClip.
+constexpr AnimationClip kCatalog[] = {
+    makeClip(kIdle, 6, AnimationClip::Type::Repeat),
+    makeClip(kRunning, 12, AnimationClip::Type::Repeat),
+    makeClip(kSliding, 10, AnimationClip::Type::OneIteration),
+    makeClip(kFalling, 12, AnimationClip::Type::Repeat),
+    makeClip(kHooked, 12, AnimationClip::Type::OneIteration),
+    makeClip(kSitting, 6, AnimationClip::Type::Repeat)};
+
+static_assert(std::size(kCatalog) == static_cast<std::size_t>(PlayerClip::Count),
+              "every PlayerClip needs an entry in the catalog");
+
+constexpr bool isValid(const AnimationClip &clip)
+{
+  return clip.frameCount > 0 && clip.speed > 0;
+}
+
+static_assert(isValid(kCatalog[0]) && isValid(kCatalog[1]) &&
+                  isValid(kCatalog[2]) && isValid(kCatalog[3]) &&
+                  isValid(kCatalog[4]) && isValid(kCatalog[5]),
+              "clips need at least one frame and a positive speed");
+} // namespace player_clips
+
+constexpr const AnimationClip &getClip(PlayerClip id)
+{
+  return player_clips::kCatalog[static_cast<std::size_t>(id)];
+}
@@ -3,9 +3,7 @@
 #include "animation.hpp"
 #include "player.hpp"
 
-PlayerState::PlayerState() {}
-
-void PlayerState::update(Player *player, float dt) { mAnimation.update(dt); }
+PlayerState::PlayerState(PlayerClip clip) noexcept : mAnimation{getClip(clip)} {}
 
 void PlayerState::setSprite(sf::Sprite &sprite, bool isFacedRight)
 {
@@ -25,37 +23,22 @@ void PlayerState::jump(Player *player, float jumpingVelocity)
 {
   player->mPosition.y -= 1;
   player->mVelocity.y = -jumpingVelocity;
-  startFalling(player);
+  player->dispatch<StartFallingEvent>();
 }
 
-PlayerState::~PlayerState() {}
-
-Idle::Idle(Player *player)
+Idle::Idle(Player *player) noexcept : PlayerState(PlayerClip::Idle)
 {
   player->mVelocity = {0, 0};
-  mAnimation = Animation();
-  mAnimation.setAnimationSpeed(6);
-  mAnimation.addTextureRect({14, 6, 21, 30});
-  mAnimation.addTextureRect({64, 6, 21, 30});
-  mAnimation.addTextureRect({114, 6, 21, 30});
-  mAnimation.addTextureRect({164, 6, 21, 30});
-
   player->mCollisionRect = sf::FloatRect(-40, -60, 80, 120);
-
-  std::cout << "Creating Idle state" << std::endl;
 }
 
-void Idle::attacked(Player *player) {}
-
-void Idle::hook(Player *player) {}
-
 void Idle::update(Player *player, float dt)
 {
   mAnimation.update(dt);
   if (sf::Keyboard::isKeyPressed(sf::Keyboard::Left) ||
       sf::Keyboard::isKeyPressed(sf::Keyboard::Right))
   {
-    player->setState(new Running(player));
+    player->setState<Running>();
   }
 }
 
@@ -66,12 +49,12 @@ void Idle::handleEvents(Player *player, const sf::Event &event)
     if (event.key.code == sf::Keyboard::Left ||
         event.key.code == sf::Keyboard::Right)
     {
-      player->setState(new Running(player));
+      player->setState<Running>();
     }
 
     if (event.key.code == sf::Keyboard::LShift)
     {
-      player->setState(new Sitting(player));
+      player->setState<Sitting>();
     }
 
     else if (event.key.code == sf::Keyboard::Space)
@@ -81,34 +64,13 @@ void Idle::handleEvents(Player *player, const sf::Event &event)
   }
 }
 
-void Idle::startFalling(Player *player)
-{
-  player->setState(new Falling(player));
-}
-
-void Idle::hitGround(Player *player) {}
-
-Running::Running(Player *player) : PlayerState()
+Running::Running(Player *player) noexcept : PlayerState(PlayerClip::Running)
 {
   mRunningSpeed = 900;
-  mAnimation = Animation();
-  mAnimation.setAnimationSpeed(12);
-  mAnimation.addTextureRect({67, 45, 20, 27});
-  mAnimation.addTextureRect({116, 46, 20, 27});
-  mAnimation.addTextureRect({166, 48, 20, 27});
-  mAnimation.addTextureRect({217, 45, 20, 27});
-  mAnimation.addTextureRect({266, 46, 20, 27});
-  mAnimation.addTextureRect({316, 48, 20, 27});
 
   player->mCollisionRect = sf::FloatRect(-40, -60, 80, 120);
-
-  std::cout << "Creating Running state" << std::endl;
 }
 
-void Running::hook(Player *player) {}
-
-void Running::attacked(Player *player) {}
-
 void Running::update(Player *player, float dt)
 {
   mAnimation.update(dt);
@@ -136,7 +98,7 @@ void Running::handleEvents(Player *player, const sf::Event &event)
 
     if (event.key.code == sf::Keyboard::LShift)
     {
-      player->setState(new Sliding(player));
+      player->setState<Sliding>();
     }
   }
   if (event.type == sf::Event::KeyReleased)
@@ -144,48 +106,27 @@ void Running::handleEvents(Player *player, const sf::Event &event)
     if (event.key.code == sf::Keyboard::Left &&
         !sf::Keyboard::isKeyPressed(sf::Keyboard::Right))
     {
-      player->setState(new Idle(player));
+      player->setState<Idle>();
       player->mVelocity.x = 0;
     }
 
     if (event.key.code == sf::Keyboard::Right &&
         !sf::Keyboard::isKeyPressed(sf::Keyboard::Left))
     {
-      player->setState(new Idle(player));
+      player->setState<Idle>();
       player->mVelocity.x = 0;
     }
   }
 }
 
-void Running::startFalling(Player *player)
-{
-  player->setState(new Falling(player));
-}
-
-void Running::hitGround(Player *player) {}
-
-Sliding::Sliding(Player *player) : PlayerState()
+Sliding::Sliding(Player *player) noexcept : PlayerState(PlayerClip::Sliding)
 {
   player->mVelocity.x *= kVelocityMultiplier;
 
-  mAnimation = Animation(Animation::AnimationType::OneIteration);
-  mAnimation.setAnimationSpeed(10);
-  mAnimation.addTextureRect({155, 119, 34, 28});
-  mAnimation.addTextureRect({205, 119, 34, 28});
-  mAnimation.addTextureRect({255, 119, 34, 28});
-  mAnimation.addTextureRect({307, 119, 34, 28});
-  mAnimation.addTextureRect({9, 156, 34, 28});
-
   player->mCollisionRect = sf::FloatRect(-80, -20, 160, 80);
   mCurrentTime = kSlidingTime;
-
-  std::cout << "Creating Sliding state" << std::endl;
 }
 
-void Sliding::hook(Player *player) {}
-
-void Sliding::attacked(Player *player) {}
-
 void Sliding::update(Player *player, float dt)
 {
   mAnimation.update(dt);
@@ -193,7 +134,7 @@ void Sliding::update(Player *player, float dt)
   mCurrentTime -= dt;
   if (mCurrentTime < 0 && player->mIsColliding)
   {
-    player->setState(new Idle(player));
+    player->setState<Idle>();
     return;
   }
 }
@@ -203,35 +144,21 @@ void Sliding::handleEvents(Player *player, const sf::Event &event)
   {
     if (event.key.code == sf::Keyboard::Left ||
         event.key.code == sf::Keyboard::Right)
-      player->setState(new Running(player));
+      player->setState<Running>();
 
     if (event.key.code == sf::Keyboard::Space && player->mIsColliding)
     {
       jump(player, kJumpingVelocity);
-      player->setState(new Falling(player));
+      player->setState<Falling>();
     }
   }
 }
 
-void Sliding::startFalling(Player *player) {}
-
-void Sliding::hitGround(Player *player) {}
-
-Falling::Falling(Player *player) : PlayerState()
+Falling::Falling(Player *player) noexcept : PlayerState(PlayerClip::Falling)
 {
-  mAnimation = Animation();
-  mAnimation.setAnimationSpeed(12);
-  mAnimation.addTextureRect({321, 155, 15, 26});
-
   player->mCollisionRect = sf::FloatRect(-40, -60, 80, 120);
-
-  std::cout << "Creating Falling state" << std::endl;
 }
 
-void Falling::hook(Player *player) { player->setState(new Hooked(player)); }
-
-void Falling::attacked(Player *player) {}
-
 void Falling::update(Player *player, float dt)
 {
   mAnimation.update(dt);
@@ -260,28 +187,11 @@ void Falling::handleEvents(Player *player, const sf::Event &event)
   }
 }
 
-void Falling::startFalling(Player *player) {}
-
-void Falling::hitGround(Player *player) { player->setState(new Idle(player)); }
-
-Hooked::Hooked(Player *player) : PlayerState()
+Hooked::Hooked(Player *player) noexcept : PlayerState(PlayerClip::Hooked)
 {
-  mAnimation = Animation(Animation::AnimationType::OneIteration);
-  mAnimation.setAnimationSpeed(12);
-  mAnimation.addTextureRect({70, 151, 16, 34});
-  mAnimation.addTextureRect({119, 151, 16, 34});
-  mAnimation.addTextureRect({169, 151, 16, 34});
-  mAnimation.addTextureRect({219, 151, 16, 34});
-
   player->mCollisionRect = sf::FloatRect(-40, -60, 80, 120);
-
-  std::cout << "Creating Hooked state" << std::endl;
 }
 
-void Hooked::hook(Player *player) {}
-
-void Hooked::attacked(Player *player) {}
-
 void Hooked::update(Player *player, float dt)
 {
   player->mVelocity = {0, 0};
@@ -298,31 +208,15 @@ void Hooked::handleEvents(Player *player, const sf::Event &event)
     else if (event.key.code == sf::Keyboard::Down)
     {
       player->mVelocity.x = player->mIsFacedRight ? -100 : 100;
-      player->setState(new Falling(player));
+      player->setState<Falling>();
     }
   }
 }
 
-void Hooked::startFalling(Player *player)
-{
-  player->setState(new Falling(player));
-}
-
-void Hooked::hitGround(Player *player) { player->setState(new Idle(player)); }
-
-Sitting::Sitting(Player *player)
+Sitting::Sitting(Player *player) noexcept : PlayerState(PlayerClip::Sitting)
 {
   player->mVelocity = {0, 0};
-  mAnimation = Animation();
-  mAnimation.setAnimationSpeed(6);
-  mAnimation.addTextureRect({214, 6, 21, 30});
-  mAnimation.addTextureRect({264, 6, 21, 30});
-  mAnimation.addTextureRect({314, 6, 21, 30});
-  mAnimation.addTextureRect({14, 43, 21, 30});
-
   player->mCollisionRect = sf::FloatRect(-40, -60, 80, 120);
-
-  std::cout << "Creating Sitting state" << std::endl;
 }
 
 void Sitting::update(Player *player, float dt)
@@ -331,7 +225,7 @@ void Sitting::update(Player *player, float dt)
   if (sf::Keyboard::isKeyPressed(sf::Keyboard::Left) ||
       sf::Keyboard::isKeyPressed(sf::Keyboard::Right))
   {
-    player->setState(new Running(player));
+    player->setState<Running>();
   }
 }
 
@@ -350,32 +244,21 @@ void Sitting::handleEvents(Player *player, const sf::Event &event)
     if (event.key.code == sf::Keyboard::Left &&
         !sf::Keyboard::isKeyPressed(sf::Keyboard::Right))
     {
-      player->setState(new Idle(player));
+      player->setState<Idle>();
       player->mVelocity.x = 0;
     }
 
     if (event.key.code == sf::Keyboard::Right &&
         !sf::Keyboard::isKeyPressed(sf::Keyboard::Left))
     {
-      player->setState(new Idle(player));
+      player->setState<Idle>();
       player->mVelocity.x = 0;
     }
 
     if (event.key.code == sf::Keyboard::LShift)
     {
-      player->setState(new Idle(player));
+      player->setState<Idle>();
       player->mVelocity = {0, 0};
     }
   }
-}
-
-void Sitting::hook(Player *player) {}
-
-void Sitting::attacked(Player *player) {}
-
-void Sitting::startFalling(Player *player)
-{
-  player->setState(new Falling(player));
-}
-
-void Sitting::hitGround(Player *player) {}
\ No newline at end of file
+}
\ No newline at end of file
@@ -1,26 +1,22 @@
 #pragma once
 #include "animation.hpp"
-#include "player.hpp"
+#include "player_clips.hpp"
+#include <type_traits>
+#include <variant>
 
 class Player;
 
 class PlayerState
 {
 public:
-  PlayerState();
+  explicit PlayerState(PlayerClip clip) noexcept;
   void setSprite(sf::Sprite &sprite, bool isFacedRight);
 
-  virtual void handleEvents(Player *player, const sf::Event &event) = 0;
-  virtual void update(Player *player, float dt);
-  virtual void hook(Player *player) = 0;
-  virtual void attacked(Player *player) = 0;
-  virtual void startFalling(Player *player) = 0;
-  virtual void hitGround(Player *player) = 0;
-  virtual ~PlayerState();
-
   void jump(Player *player, float jumpingVelocity);
 
 protected:
+  ~PlayerState() = default;
+
   Animation mAnimation;
   static constexpr float kJumpingVelocity = 1500;
   static constexpr float kSubJumpingVelocity = 1000;
@@ -29,14 +25,10 @@ protected:
 class Idle final : public PlayerState
 {
 public:
-  Idle(Player *player);
+  Idle(Player *player) noexcept;
 
   void update(Player *player, float dt);
   void handleEvents(Player *player, const sf::Event &event);
-  void hook(Player *player);
-  void attacked(Player *player);
-  void startFalling(Player *player);
-  void hitGround(Player *player);
 
 private:
 };
@@ -44,13 +36,9 @@ private:
 class Running final : public PlayerState
 {
 public:
-  Running(Player *player);
+  Running(Player *player) noexcept;
   void update(Player *player, float dt);
   void handleEvents(Player *player, const sf::Event &event);
-  void hook(Player *player);
-  void attacked(Player *player);
-  void startFalling(Player *player);
-  void hitGround(Player *player);
 
 private:
   float mRunningSpeed;
@@ -60,13 +48,9 @@ class Sliding final : public PlayerState
 {
 
 public:
-  Sliding(Player *player);
+  Sliding(Player *player) noexcept;
   void update(Player *player, float dt);
   void handleEvents(Player *player, const sf::Event &event);
-  void hook(Player *player);
-  void attacked(Player *player);
-  void startFalling(Player *player);
-  void hitGround(Player *player);
 
 private:
   float mCurrentTime;
@@ -78,13 +62,9 @@ private:
 class Falling final : public PlayerState
 {
 public:
-  Falling(Player *player);
+  Falling(Player *player) noexcept;
   void update(Player *player, float dt);
   void handleEvents(Player *player, const sf::Event &event);
-  void hook(Player *player);
-  void attacked(Player *player);
-  void startFalling(Player *player);
-  void hitGround(Player *player);
 
 private:
   unsigned jumpCount = 0;
@@ -96,25 +76,126 @@ class Hooked final : public PlayerState
 public:
   static constexpr float kMaxHookOffset = 15;
 
-  Hooked(Player *player);
+  Hooked(Player *player) noexcept;
   void update(Player *player, float dt);
   void handleEvents(Player *player, const sf::Event &event);
-  void hook(Player *player);
-  void attacked(Player *player);
-  void startFalling(Player *player);
-  void hitGround(Player *player);
 };
 
 class Sitting final : public PlayerState
 {
 public:
-  Sitting(Player *player);
+  Sitting(Player *player) noexcept;
   void update(Player *player, float dt);
   void handleEvents(Player *player, const sf::Event &event);
-  void hook(Player *player);
-  void attacked(Player *player);
-  void startFalling(Player *player);
-  void hitGround(Player *player);
 
 private:
 };
+
+// Every state a Player can be in. Player stores the current one in place.
+using PlayerStates =
+    std::variant<Idle, Running, Sliding, Falling, Hooked, Sitting>;
+
+// Events that only ever switch state. Each one picks its column of a
+// state's row in the transition table below.
+struct HookEvent
+{
+  template <typename Row> using Target = typename Row::OnHook;
+};
+
+struct AttackedEvent
+{
+  template <typename Row> using Target = typename Row::OnAttacked;
+};
+
+struct StartFallingEvent
+{
+  template <typename Row> using Target = typename Row::OnStartFalling;
+};
+
+struct HitGroundEvent
+{
+  template <typename Row> using Target = typename Row::OnHitGround;
+};
+
+// Target meaning "ignore the event". Player::dispatch compiles it to nothing.
+struct Stay
+{
+};
+
+template <typename Hook, typename Attacked, typename StartFalling,
+          typename HitGround>
+struct Transitions
+{
+  using OnHook = Hook;
+  using OnAttacked = Attacked;
+  using OnStartFalling = StartFalling;
+  using OnHitGround = HitGround;
+};
+
+// One row per state, one column per event. There is no default row, so a
+// new state does not compile until it says what every event does.
+template <typename State> struct TransitionTable;
+
+// clang-format off
+//                                          hook    attacked startFalling hitGround
+template <> struct TransitionTable<Idle>    : Transitions<Stay,   Stay,    Falling,     Stay> {};
+template <> struct TransitionTable<Running> : Transitions<Stay,   Stay,    Falling,     Stay> {};
+template <> struct TransitionTable<Sliding> : Transitions<Stay,   Stay,    Stay,        Stay> {};
+template <> struct TransitionTable<Falling> : Transitions<Hooked, Stay,    Stay,        Idle> {};
+template <> struct TransitionTable<Hooked>  : Transitions<Stay,   Stay,    Falling,     Idle> {};
+template <> struct TransitionTable<Sitting> : Transitions<Stay,   Stay,    Falling,     Stay> {};
+// clang-format on
+
+template <typename State, typename Event>
+using TransitionTarget =
+    typename Event::template Target<TransitionTable<State>>;
+
+template <typename Target, typename States> struct IsTransitionTarget;
+
+template <typename Target, typename... States>
+struct IsTransitionTarget<Target, std::variant<States...>>
+    : std::bool_constant<std::is_same<Target, Stay>::value ||
+                         (std::is_same<Target, States>::value || ...)>
+{
+};
+
+template <typename State, typename = void>
+struct HandlesAllEvents : std::false_type
+{
+};
+
+template <typename State>
+struct HandlesAllEvents<
+    State,
+    std::void_t<TransitionTarget<State, HookEvent>,
+                TransitionTarget<State, AttackedEvent>,
+                TransitionTarget<State, StartFallingEvent>,
+                TransitionTarget<State, HitGroundEvent>,
+                decltype(std::declval<State &>().update(nullptr, 0.f)),
+                decltype(std::declval<State &>().handleEvents(
+                    nullptr, std::declval<const sf::Event &>()))>>
+    : std::bool_constant<
+          std::is_nothrow_constructible<State, Player *>::value &&
+          IsTransitionTarget<TransitionTarget<State, HookEvent>,
+                             PlayerStates>::value &&
+          IsTransitionTarget<TransitionTarget<State, AttackedEvent>,
+                             PlayerStates>::value &&
+          IsTransitionTarget<TransitionTarget<State, StartFallingEvent>,
+                             PlayerStates>::value &&
+          IsTransitionTarget<TransitionTarget<State, HitGroundEvent>,
+                             PlayerStates>::value>
+{
+};
+
+template <typename States> struct IsCompleteStateMachine;
+
+template <typename... States>
+struct IsCompleteStateMachine<std::variant<States...>>
+    : std::bool_constant<(HandlesAllEvents<States>::value && ...)>
+{
+};
+
+static_assert(IsCompleteStateMachine<PlayerStates>::value,
+              "every player state needs a noexcept constructor, update, "
+              "handleEvents and a transition table row that targets player "
+              "states only");
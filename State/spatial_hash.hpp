@@ -0,0 +1,92 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Uniform grid over world space for finding the rectangles near a point of
+// interest. Each rectangle is stored by index in every cell it touches, so a
+// query only looks at the cells its area covers. Rectangles spanning more
+// than kMaxCellsPerRect cells (e.g. a level-wide floor) are kept in a short
+// list that every query returns instead.
+class SpatialHash
+{
+public:
+  static constexpr int kMaxCellsPerRect = 64;
+
+  explicit SpatialHash(float cellSize = 256) : mCellSize{cellSize} {}
+
+  void insert(const sf::FloatRect &rect, std::uint32_t index)
+  {
+    CellRange range = cellsOf(rect);
+    if (range.count() > kMaxCellsPerRect)
+    {
+      mOversized.push_back(index);
+    }
+    else
+    {
+      for (std::int32_t y = range.top; y <= range.bottom; ++y)
+        for (std::int32_t x = range.left; x <= range.right; ++x)
+          mCells[key(x, y)].push_back(index);
+    }
+  }
+
+  // Replaces the contents of `result` with the indices of every rectangle
+  // that may overlap `area`, each once and in ascending order. Several
+  // threads may query at once, each with its own `result`.
+  void query(const sf::FloatRect &area,
+             std::vector<std::uint32_t> &result) const
+  {
+    result.clear();
+    CellRange range = cellsOf(area);
+    for (std::int32_t y = range.top; y <= range.bottom; ++y)
+    {
+      for (std::int32_t x = range.left; x <= range.right; ++x)
+      {
+        auto cell = mCells.find(key(x, y));
+        if (cell == mCells.end())
+          continue;
+        result.insert(result.end(), cell->second.begin(), cell->second.end());
+      }
+    }
+    result.insert(result.end(), mOversized.begin(), mOversized.end());
+
+    // A rectangle spanning several queried cells is reported once.
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+  }
+
+private:
+  struct CellRange
+  {
+    std::int32_t left, top, right, bottom;
+
+    long long count() const
+    {
+      return static_cast<long long>(right - left + 1) * (bottom - top + 1);
+    }
+  };
+
+  CellRange cellsOf(const sf::FloatRect &rect) const
+  {
+    return {cell(rect.left), cell(rect.top), cell(rect.left + rect.width),
+            cell(rect.top + rect.height)};
+  }
+
+  std::int32_t cell(float coordinate) const
+  {
+    return static_cast<std::int32_t>(std::floor(coordinate / mCellSize));
+  }
+
+  static std::uint64_t key(std::int32_t x, std::int32_t y)
+  {
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32) |
+           static_cast<std::uint32_t>(y);
+  }
+
+  float mCellSize;
+  std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> mCells{};
+  std::vector<std::uint32_t> mOversized{};
+};
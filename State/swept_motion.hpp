@@ -0,0 +1,140 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Moving a box through the level's blocks without passing through any of
+// them, shared by the player and the crowd.
+namespace swept_motion
+{
+// Slack for positions that should be exactly in contact but are off by
+// rounding.
+constexpr float kContactTolerance = 0.01f;
+
+// Entry and exit times of a moving box along one axis, as fractions of the
+// motion. Without motion the box either always or never overlaps; touching
+// does not count, so a box resting on one block slides past the side of a
+// level neighbour instead of stopping at the seam.
+inline bool sweepAxis(float boxMin, float boxMax, float motion, float blockMin,
+                      float blockMax, float &entry, float &exit)
+{
+  if (motion == 0)
+  {
+    entry = -std::numeric_limits<float>::infinity();
+    exit = std::numeric_limits<float>::infinity();
+    return boxMax - blockMin > kContactTolerance &&
+           blockMax - boxMin > kContactTolerance;
+  }
+  float entryDistance = motion > 0 ? blockMin - boxMax : blockMax - boxMin;
+  float exitDistance = motion > 0 ? blockMax - boxMin : blockMin - boxMax;
+  if (entryDistance < 0 && entryDistance > -kContactTolerance)
+    entryDistance = 0;
+  entry = entryDistance / motion;
+  exit = exitDistance / motion;
+  return true;
+}
+
+// Time in [0, 1) at which `box` moving by `motion` reaches the core of
+// `block`, and the axis of the face it reaches (0 for x, 1 for y). The core
+// is the block shrunk by `depth`, so a box resting in contact with the
+// block, `depth` inside it, sits right on the core's surface. Boxes that are
+// already deeper are left to overlap resolution.
+inline bool sweep(const sf::FloatRect &box, sf::Vector2f motion,
+                  const sf::FloatRect &block, float depth, float &time,
+                  int &axis)
+{
+  float insetX = std::min(depth, block.width / 2);
+  float insetY = std::min(depth, block.height / 2);
+  sf::FloatRect core{block.left + insetX, block.top + insetY,
+                     block.width - 2 * insetX, block.height - 2 * insetY};
+
+  bool embedded =
+      box.left + box.width - core.left > kContactTolerance &&
+      core.left + core.width - box.left > kContactTolerance &&
+      box.top + box.height - core.top > kContactTolerance &&
+      core.top + core.height - box.top > kContactTolerance;
+  if (embedded)
+    return false;
+
+  float entryX, exitX, entryY, exitY;
+  if (!sweepAxis(box.left, box.left + box.width, motion.x, core.left,
+                 core.left + core.width, entryX, exitX) ||
+      !sweepAxis(box.top, box.top + box.height, motion.y, core.top,
+                 core.top + core.height, entryY, exitY))
+    return false;
+
+  float entry = std::max(entryX, entryY);
+  float exit = std::min(exitX, exitY);
+  if (entry > exit || entry < 0 || entry >= 1)
+    return false;
+
+  time = entry;
+  axis = entryX > entryY ? 0 : 1;
+  return true;
+}
+
+// Bounds covering `box` both before and after `motion`.
+inline sf::FloatRect sweptBounds(const sf::FloatRect &box, sf::Vector2f motion)
+{
+  float left = std::min(box.left, box.left + motion.x);
+  float top = std::min(box.top, box.top + motion.y);
+  return {left, top, box.width + std::abs(motion.x),
+          box.height + std::abs(motion.y)};
+}
+
+// Area to query for the blocks a box may touch this step: its swept bounds
+// plus room for overlap resolution, which pushes it by roughly its own size
+// at most.
+inline sf::FloatRect queryArea(const sf::FloatRect &swept,
+                               const sf::FloatRect &box)
+{
+  float margin = 2 * std::max(box.width, box.height);
+  return {swept.left - margin, swept.top - margin, swept.width + 2 * margin,
+          swept.height + 2 * margin};
+}
+
+// Moves `position` by `motion`, but stops at the first face of a candidate
+// block that the box `rect` (relative to the position) would pass into, then
+// keeps sliding along it, for at most `maxSweeps` faces. Blocked moves end
+// `depth` inside the face they hit.
+inline void move(sf::Vector2f &position, const sf::FloatRect &rect,
+                 sf::Vector2f motion, const std::vector<sf::FloatRect> &blocks,
+                 const std::vector<std::uint32_t> &candidates, float depth,
+                 int maxSweeps)
+{
+  sf::Vector2f remaining = motion;
+  for (int i = 0; i < maxSweeps && (remaining.x != 0 || remaining.y != 0);
+       ++i)
+  {
+    sf::FloatRect box{position.x + rect.left, position.y + rect.top,
+                      rect.width, rect.height};
+    float hitTime = 1;
+    int hitAxis = -1;
+    for (std::uint32_t index : candidates)
+    {
+      float time;
+      int axis;
+      if (sweep(box, remaining, blocks[index], depth, time, axis) &&
+          time < hitTime)
+      {
+        hitTime = time;
+        hitAxis = axis;
+      }
+    }
+
+    if (hitAxis < 0)
+    {
+      position += remaining;
+      return;
+    }
+
+    sf::Vector2f step = remaining * hitTime;
+    position += step;
+    remaining -= step;
+    (hitAxis == 0 ? remaining.x : remaining.y) = 0;
+  }
+}
+} // namespace swept_motion
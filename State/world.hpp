@@ -1,13 +1,30 @@
 #pragma once
+#include "block_bvh.hpp"
+#include "block_renderer.hpp"
+#include "characters.hpp"
+#include "job_system.hpp"
 #include "player.hpp"
 #include "player_states.hpp"
+#include "spatial_hash.hpp"
+#include "swept_motion.hpp"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
 class World
 {
 public:
-  void addBlock(sf::FloatRect block) { mBlocks.push_back(block); }
+  void addBlock(sf::FloatRect block)
+  {
+    mGrid.insert(block, static_cast<std::uint32_t>(mBlocks.size()));
+    mBlocks.push_back(block);
+    mBlockRenderer.add(block);
+  }
+
+  std::uint32_t addCharacter(sf::Vector2f position)
+  {
+    return mCharacters.add(position);
+  }
 
   void setView()
   {
@@ -39,35 +56,60 @@ public:
   void update(float dt)
   {
     mTime += dt;
+    mPreviousViewCenter = mView.getCenter();
     setView();
     mPlayer.applyVelocity({0, mGravity * dt});
     mPlayer.update(dt);
-    mPlayer.handleAllCollisions(mBlocks);
+
+    mGrid.query(swept_motion::queryArea(mPlayer.getSweptBounds(),
+                                        mPlayer.getCollisionBounds()),
+                mCandidates);
+    mPlayer.move(mBlocks, mCandidates);
+    mPlayer.handleAllCollisions(mBlocks, mCandidates);
+
+    mCharacters.update(mGravity, dt, mBlocks, mGrid, mJobs);
   }
 
-  void draw(sf::RenderWindow &window)
+  // alpha blends the previous simulation step with the current one, see
+  // Player::draw.
+  void draw(sf::RenderWindow &window, float alpha = 1)
   {
-    static sf::RectangleShape blockShape;
-    blockShape.setFillColor(sf::Color(58, 69, 55));
-
-    window.setView(mView);
+    sf::View view = mView;
+    view.setCenter(mPreviousViewCenter +
+                   (mView.getCenter() - mPreviousViewCenter) * alpha);
+    window.setView(view);
 
-    for (const sf::FloatRect &b : mBlocks)
-    {
-      blockShape.setPosition(b.left, b.top);
-      blockShape.setSize({b.width, b.height});
-      window.draw(blockShape);
-    }
-    mPlayer.draw(window);
+    sf::FloatRect visible{view.getCenter() - view.getSize() / 2.f,
+                          view.getSize()};
+    mBlockRenderer.draw(window, visible);
+    mCharacters.draw(window, visible, alpha);
+    mPlayer.draw(window, alpha);
   }
 
   void handleEvents(const sf::Event &event) { mPlayer.handleEvents(event); }
 
+  // Hierarchy over the blocks for ground probes, line of sight and camera
+  // checks. It is built on first use after the level is loaded; adding
+  // blocks afterwards rebuilds it on the next call.
+  const BlockBvh &getGeometry()
+  {
+    if (mBvh.size() != mBlocks.size())
+      mBvh.build(mBlocks);
+    return mBvh;
+  }
+
 private:
   std::vector<sf::FloatRect> mBlocks{};
+  SpatialHash mGrid{};
+  BlockBvh mBvh{};
+  BlockRenderer mBlockRenderer{sf::Color(58, 69, 55)};
+  std::vector<std::uint32_t> mCandidates{};
   Player mPlayer{{400, 400}};
+  Characters mCharacters{};
+  JobSystem mJobs{};
   float mGravity{3600};
 
   sf::View mView{sf::FloatRect(0, 0, 1200, 900)};
+  sf::Vector2f mPreviousViewCenter{mView.getCenter()};
   float mTime{0};
 };
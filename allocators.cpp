@@ -0,0 +1,258 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace custom_classes
+{
+
+    // Bump allocator over a list of chunks. Single deallocations are no-ops;
+    // everything is freed at once by release() or the destructor, which fits
+    // objects that live for one frame or one level. Destructors of objects
+    // still alive at release() are not run. Not thread-safe.
+    class monotonic_arena
+    {
+    public:
+        explicit monotonic_arena(size_t chunk_size = 64 * 1024) : chunk_size_(chunk_size) {}
+        monotonic_arena(const monotonic_arena &) = delete;
+        monotonic_arena &operator=(const monotonic_arena &) = delete;
+        ~monotonic_arena() { release(); }
+
+        void *allocate(size_t size, size_t alignment)
+        {
+            char *ptr = align_up(cursor_, alignment);
+            if (cursor_ == nullptr || ptr + size > end_)
+            {
+                add_chunk(size + alignment);
+                ptr = align_up(cursor_, alignment);
+            }
+            cursor_ = ptr + size;
+            bytes_used_ += size;
+            return ptr;
+        }
+
+        void deallocate(void *, size_t) noexcept {}
+
+        void release() noexcept
+        {
+            while (head_ != nullptr)
+            {
+                chunk *next = head_->next_;
+                ::operator delete(head_);
+                head_ = next;
+            }
+            cursor_ = end_ = nullptr;
+            bytes_used_ = 0;
+        }
+
+        size_t bytes_used() const noexcept { return bytes_used_; }
+
+    private:
+        struct chunk
+        {
+            chunk *next_;
+        };
+
+        static char *align_up(char *ptr, size_t alignment) noexcept
+        {
+            auto address = reinterpret_cast<std::uintptr_t>(ptr);
+            return reinterpret_cast<char *>((address + alignment - 1) & ~(alignment - 1));
+        }
+
+        void add_chunk(size_t min_size)
+        {
+            size_t size = std::max(chunk_size_, min_size + sizeof(chunk));
+            auto *new_chunk = static_cast<chunk *>(::operator new(size));
+            new_chunk->next_ = head_;
+            head_ = new_chunk;
+            cursor_ = reinterpret_cast<char *>(new_chunk + 1);
+            end_ = reinterpret_cast<char *>(new_chunk) + size;
+        }
+
+        chunk *head_{nullptr};
+        char *cursor_{nullptr};
+        char *end_{nullptr};
+        size_t chunk_size_;
+        size_t bytes_used_{0};
+    };
+
+    // Standard allocator interface over a monotonic_arena.
+    template <typename data_t>
+    struct arena_allocator
+    {
+        using value_type = data_t;
+
+        monotonic_arena *arena_;
+
+        arena_allocator(monotonic_arena &arena) noexcept : arena_(&arena) {}
+
+        template <typename T>
+        arena_allocator(const arena_allocator<T> &other) noexcept : arena_(other.arena_) {}
+
+        data_t *allocate(size_t n)
+        {
+            return static_cast<data_t *>(arena_->allocate(n * sizeof(data_t), alignof(data_t)));
+        }
+
+        void deallocate(data_t *ptr, size_t n) noexcept { arena_->deallocate(ptr, n); }
+
+        template <typename T>
+        bool operator==(const arena_allocator<T> &other) const noexcept
+        {
+            return arena_ == other.arena_;
+        }
+
+        template <typename T>
+        bool operator!=(const arena_allocator<T> &other) const noexcept
+        {
+            return arena_ != other.arena_;
+        }
+    };
+
+    namespace detail
+    {
+        // Free list of fixed-size blocks. Each thread keeps its own list, so
+        // allocation and deallocation take no lock. Threads refill from (and
+        // on exit hand their blocks back to) a shared list; slabs are only
+        // returned to the system at program exit.
+        template <size_t block_size>
+        class fixed_pool
+        {
+            struct node
+            {
+                node *next_;
+            };
+
+            struct shared_state
+            {
+                std::mutex mutex_;
+                node *free_{nullptr};
+                std::vector<void *> slabs_;
+
+                ~shared_state()
+                {
+                    for (void *slab : slabs_)
+                        ::operator delete(slab);
+                }
+            };
+
+            static shared_state &shared()
+            {
+                static shared_state state;
+                return state;
+            }
+
+            node *free_{nullptr};
+
+            void refill()
+            {
+                shared_state &state = shared();
+                std::lock_guard<std::mutex> lock(state.mutex_);
+                if (state.free_ != nullptr)
+                {
+                    std::swap(free_, state.free_);
+                    return;
+                }
+
+                char *slab = static_cast<char *>(::operator new(kSlabBlocks * block_size));
+                state.slabs_.push_back(slab);
+                for (size_t i = 0; i < kSlabBlocks; ++i)
+                    push(slab + i * block_size);
+            }
+
+            void push(void *ptr) noexcept
+            {
+                node *block = static_cast<node *>(ptr);
+                block->next_ = free_;
+                free_ = block;
+            }
+
+        public:
+            static constexpr size_t kSlabBlocks = 256;
+
+            static fixed_pool &local()
+            {
+                thread_local fixed_pool pool;
+                return pool;
+            }
+
+            ~fixed_pool()
+            {
+                if (free_ == nullptr)
+                    return;
+                node *last = free_;
+                while (last->next_ != nullptr)
+                    last = last->next_;
+
+                shared_state &state = shared();
+                std::lock_guard<std::mutex> lock(state.mutex_);
+                last->next_ = state.free_;
+                state.free_ = free_;
+            }
+
+            void *allocate()
+            {
+                if (free_ == nullptr)
+                    refill();
+                node *block = free_;
+                free_ = block->next_;
+                return block;
+            }
+
+            void deallocate(void *ptr) noexcept { push(ptr); }
+        };
+
+        constexpr size_t pool_block_size(size_t size)
+        {
+            size_t align = alignof(std::max_align_t);
+            return (std::max(size, sizeof(void *)) + align - 1) / align * align;
+        }
+    }
+
+    // Allocator that serves single objects from a thread-local free list of
+    // blocks of the object's size. Larger requests go to global new.
+    template <typename data_t>
+    struct pool_allocator
+    {
+        using value_type = data_t;
+
+        pool_allocator() noexcept = default;
+
+        template <typename T>
+        pool_allocator(const pool_allocator<T> &) noexcept {}
+
+        // Looked up lazily: data_t may still be incomplete where the allocator
+        // type is named, e.g. inside a control block that stores it.
+        static auto &pool()
+        {
+            static_assert(alignof(data_t) <= alignof(std::max_align_t),
+                          "over-aligned types are not supported by pool_allocator");
+            return detail::fixed_pool<detail::pool_block_size(sizeof(data_t))>::local();
+        }
+
+        data_t *allocate(size_t n)
+        {
+            if (n == 1)
+                return static_cast<data_t *>(pool().allocate());
+            return static_cast<data_t *>(::operator new(n * sizeof(data_t)));
+        }
+
+        void deallocate(data_t *ptr, size_t n) noexcept
+        {
+            if (n == 1)
+                pool().deallocate(ptr);
+            else
+                ::operator delete(ptr);
+        }
+
+        template <typename T>
+        bool operator==(const pool_allocator<T> &) const noexcept { return true; }
+
+        template <typename T>
+        bool operator!=(const pool_allocator<T> &) const noexcept { return false; }
+    };
+
+}
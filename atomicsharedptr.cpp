@@ -0,0 +1,121 @@
+#pragma once
+#include "sharedptr.cpp"
+#include <atomic>
+#include <cstdint>
+
+namespace custom_classes
+{
+
+    // A shared_ptr slot that many threads may load() from while others
+    // store() into it, without locks.
+    //
+    // Every store() publishes a small holder block (an inplace_block owning a
+    // copy of the shared_ptr). The slot is one atomic word: the holder address
+    // in the low 48 bits and a count of readers that are between "saw this
+    // holder" and "took a reference to it" in the high 16 bits (a split
+    // reference count). A reader bumps that local count, takes a real
+    // reference on the holder and then gives the local count back. A writer
+    // that swaps the holder out moves whatever local count is left onto the
+    // holder's own counter, so a reader that lost the race simply drops the
+    // extra reference instead.
+    //
+    // Requires user-space addresses to fit in 48 bits (x86-64, AArch64).
+    template <typename data_t>
+    class atomic_shared_ptr
+    {
+    public:
+        using value_type = shared_ptr<data_t, atomic_policy>;
+
+        atomic_shared_ptr() noexcept = default;
+        atomic_shared_ptr(const value_type &value) : word_(pack(make_holder(value))) {}
+        atomic_shared_ptr(const atomic_shared_ptr &) = delete;
+        atomic_shared_ptr &operator=(const atomic_shared_ptr &) = delete;
+
+        ~atomic_shared_ptr()
+        {
+            if (holder *block = unpack(word_.load(std::memory_order_acquire)))
+                block->release();
+        }
+
+        static constexpr bool is_lock_free() noexcept { return true; }
+
+        value_type load() const noexcept
+        {
+            std::uint64_t word = word_.fetch_add(kLocalOne, std::memory_order_acquire);
+            holder *block = unpack(word);
+            if (block == nullptr)
+            {
+                give_back_local(nullptr);
+                return value_type();
+            }
+
+            block->add_ref();
+            if (!give_back_local(block))
+                block->release(); // the writer already credited our reference
+
+            value_type value(*block->get());
+            block->release();
+            return value;
+        }
+
+        void store(const value_type &value) { exchange(value); }
+
+        value_type exchange(const value_type &value)
+        {
+            holder *fresh = make_holder(value);
+            std::uint64_t old = word_.exchange(pack(fresh), std::memory_order_acq_rel);
+            holder *block = unpack(old);
+            if (block == nullptr)
+                return value_type();
+
+            // Readers that incremented the local count will each drop one
+            // reference once they notice the swap.
+            if (std::uint64_t readers = old >> kPointerBits)
+                block->add_ref(readers);
+
+            value_type previous(*block->get());
+            block->release();
+            return previous;
+        }
+
+    private:
+        using holder = detail::inplace_block<value_type, atomic_policy>;
+
+        static constexpr unsigned kPointerBits = 48;
+        static constexpr std::uint64_t kPointerMask = (std::uint64_t{1} << kPointerBits) - 1;
+        static constexpr std::uint64_t kLocalOne = std::uint64_t{1} << kPointerBits;
+
+        static_assert(sizeof(void *) == sizeof(std::uint64_t),
+                      "atomic_shared_ptr packs pointers into 64-bit words");
+
+        // Holders are internal, so they record no call site.
+        static holder *make_holder(const value_type &value) { return new holder(nullptr, value); }
+
+        static std::uint64_t pack(holder *block) noexcept
+        {
+            return reinterpret_cast<std::uintptr_t>(block);
+        }
+
+        static holder *unpack(std::uint64_t word) noexcept
+        {
+            return reinterpret_cast<holder *>(static_cast<std::uintptr_t>(word & kPointerMask));
+        }
+
+        // Decrements the local count if `block` is still published. Returns
+        // false if a writer replaced it in the meantime.
+        bool give_back_local(holder *block) const noexcept
+        {
+            std::uint64_t word = word_.load(std::memory_order_relaxed);
+            while (unpack(word) == block)
+            {
+                if (word_.compare_exchange_weak(word, word - kLocalOne, std::memory_order_release,
+                                                std::memory_order_relaxed))
+                    return true;
+            }
+            return false;
+        }
+
+        mutable std::atomic<std::uint64_t> word_{0};
+    };
+
+}
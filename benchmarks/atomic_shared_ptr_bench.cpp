@@ -0,0 +1,160 @@
+// g++ -std=c++17 -O2 -pthread atomic_shared_ptr_bench.cpp -o atomic_shared_ptr_bench
+//
+// First runs a stress test that checks every snapshot a reader sees is
+// complete and that no version leaks, then measures reader throughput with
+// and without a concurrent writer, against a mutex-protected shared_ptr.
+#include "../atomicsharedptr.cpp"
+#include "bench.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using custom_classes::atomic_policy;
+using custom_classes::atomic_shared_ptr;
+using custom_classes::make_shared;
+using custom_classes::shared_ptr;
+
+std::atomic<long> gLiveConfigs{0};
+
+struct LevelConfig
+{
+    std::array<long, 16> fields;
+
+    explicit LevelConfig(long version)
+    {
+        fields.fill(version);
+        gLiveConfigs.fetch_add(1, std::memory_order_relaxed);
+    }
+    ~LevelConfig() { gLiveConfigs.fetch_sub(1, std::memory_order_relaxed); }
+
+    bool consistent() const
+    {
+        return std::all_of(fields.begin(), fields.end(), [&](long f)
+                           { return f == fields[0]; });
+    }
+};
+
+using ConfigPtr = shared_ptr<LevelConfig, atomic_policy>;
+
+void stress(unsigned readers, unsigned writers, size_t iterations)
+{
+    {
+        atomic_shared_ptr<LevelConfig> slot(make_shared<LevelConfig, atomic_policy>(0));
+        std::atomic<bool> failed{false};
+        std::vector<std::thread> threads;
+
+        for (unsigned r = 0; r < readers; ++r)
+            threads.emplace_back([&]()
+                                 {
+                                     long last = 0;
+                                     for (size_t i = 0; i < iterations; ++i)
+                                     {
+                                         ConfigPtr config = slot.load();
+                                         if (!config->consistent() || config.use_count() < 1)
+                                             failed = true;
+                                         last = std::max(last, config->fields[0]);
+                                     }
+                                     bench::do_not_optimize(last);
+                                 });
+        for (unsigned w = 0; w < writers; ++w)
+            threads.emplace_back([&, w]()
+                                 {
+                                     for (size_t i = 1; i <= iterations / 8; ++i)
+                                         slot.store(make_shared<LevelConfig, atomic_policy>(
+                                             static_cast<long>(i * writers + w)));
+                                 });
+        for (auto &thread : threads)
+            thread.join();
+
+        if (failed)
+        {
+            std::printf("stress: inconsistent snapshot\n");
+            std::exit(1);
+        }
+    }
+    if (gLiveConfigs.load() != 0)
+    {
+        std::printf("stress: %ld configs leaked\n", gLiveConfigs.load());
+        std::exit(1);
+    }
+    std::printf("stress readers=%u writers=%u: ok\n", readers, writers);
+}
+
+template <typename Load, typename Store>
+double reader_throughput(unsigned readers, bool with_writer, Load load, Store store)
+{
+    const auto kDuration = std::chrono::milliseconds(300);
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> total{0};
+    std::vector<std::thread> threads;
+
+    for (unsigned r = 0; r < readers; ++r)
+        threads.emplace_back([&]()
+                             {
+                                 size_t count = 0;
+                                 long sum = 0;
+                                 while (!stop.load(std::memory_order_relaxed))
+                                 {
+                                     sum += load()->fields[0];
+                                     ++count;
+                                 }
+                                 bench::do_not_optimize(sum);
+                                 total += count;
+                             });
+    if (with_writer)
+        threads.emplace_back([&]()
+                             {
+                                 for (long version = 1; !stop.load(std::memory_order_relaxed); ++version)
+                                 {
+                                     store(make_shared<LevelConfig, atomic_policy>(version));
+                                     std::this_thread::sleep_for(std::chrono::microseconds(100));
+                                 }
+                             });
+
+    std::this_thread::sleep_for(kDuration);
+    stop = true;
+    for (auto &thread : threads)
+        thread.join();
+    return total.load() / std::chrono::duration<double>(kDuration).count() / 1e6;
+}
+
+int main()
+{
+    unsigned max_threads = std::max(4u, std::thread::hardware_concurrency());
+
+    stress(4, 1, 200'000);
+    stress(4, 3, 200'000);
+
+    atomic_shared_ptr<LevelConfig> slot(make_shared<LevelConfig, atomic_policy>(0));
+    auto atomic_load = [&]()
+    { return slot.load(); };
+    auto atomic_store = [&](const ConfigPtr &config)
+    { slot.store(config); };
+
+    std::mutex mutex;
+    ConfigPtr guarded = make_shared<LevelConfig, atomic_policy>(0);
+    auto mutex_load = [&]()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return guarded;
+    };
+    auto mutex_store = [&](const ConfigPtr &config)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        guarded = config;
+    };
+
+    for (bool with_writer : {false, true})
+        for (unsigned readers = 1; readers <= max_threads; readers *= 2)
+        {
+            std::printf("readers=%-3u writer=%d  atomic_shared_ptr %8.2f Mloads/s  "
+                        "mutex+shared_ptr %8.2f Mloads/s\n",
+                        readers, with_writer,
+                        reader_throughput(readers, with_writer, atomic_load, atomic_store),
+                        reader_throughput(readers, with_writer, mutex_load, mutex_store));
+        }
+    return 0;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace bench
+{
+    // Keeps the optimizer from dropping the value.
+    template <typename data_t>
+    inline void do_not_optimize(data_t const &value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    // Runs `body` `iterations` times and returns nanoseconds per iteration.
+    template <typename Body>
+    double measure(size_t iterations, Body &&body)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i)
+            body(i);
+        auto stop = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(stop - start).count() /
+               static_cast<double>(iterations);
+    }
+
+    inline void report(const std::string &name, double ns_per_op)
+    {
+        std::printf("%-40s %10.2f ns/op\n", name.c_str(), ns_per_op);
+    }
+}
@@ -0,0 +1,57 @@
+// g++ -std=c++17 -O2 -pthread broadphase_bench.cpp -o broadphase_bench -lsfml-graphics -lsfml-window -lsfml-system
+//
+// Run from State/ so that Player finds images/hero.png.
+//
+// Per-tick cost of World::update, which finds collision candidates through
+// its spatial hash, for levels of 10k to 1M blocks at the same density. A
+// full scan of the blocks with Player::handleAllCollisions is timed as well
+// for comparison.
+#include "../State/player.cpp"
+#include "../State/player_states.cpp"
+#include "../State/world.hpp"
+#include "bench.hpp"
+#include <cmath>
+#include <random>
+#include <string>
+
+namespace
+{
+    std::vector<sf::FloatRect> makeLevel(size_t count)
+    {
+        // About one block per 600x600 area, whatever the level size.
+        float side = std::sqrt(static_cast<float>(count)) * 600;
+        std::mt19937 random(42);
+        std::uniform_real_distribution<float> position(-side / 2, side / 2);
+        std::uniform_real_distribution<float> size(50, 400);
+
+        std::vector<sf::FloatRect> blocks;
+        blocks.push_back({-500, 770, 20000, 400});
+        while (blocks.size() < count)
+            blocks.push_back({position(random), position(random), size(random), size(random)});
+        return blocks;
+    }
+}
+
+int main()
+{
+    const float dt = 1.0f / 60;
+
+    for (size_t count : {10'000, 100'000, 1'000'000})
+    {
+        std::vector<sf::FloatRect> blocks = makeLevel(count);
+
+        World world;
+        for (const sf::FloatRect &block : blocks)
+            world.addBlock(block);
+        double ns = bench::measure(10'000, [&](size_t) { world.update(dt); });
+        bench::report("World::update, " + std::to_string(count) + " blocks", ns);
+
+        Player player({400, 400});
+        ns = bench::measure(count >= 1'000'000 ? 20 : 200, [&](size_t) {
+            player.handleAllCollisions(blocks);
+            bench::do_not_optimize(player);
+        });
+        bench::report("full scan, " + std::to_string(count) + " blocks", ns);
+    }
+    return 0;
+}
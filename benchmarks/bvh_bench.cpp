@@ -0,0 +1,141 @@
+// g++ -std=c++17 -O2 bvh_bench.cpp -o bvh_bench
+//
+// Batched queries against BlockBvh on levels of 10k to 1M blocks at the
+// same density: overlap areas, short downward rays (ground probes), long
+// rays (line of sight) and swept player-sized boxes. Each batch is also run
+// as a scan over every block for comparison; the scans are only timed on
+// the smaller levels. Times are per query.
+#include "../State/block_bvh.hpp"
+#include "bench.hpp"
+#include <cmath>
+#include <random>
+#include <string>
+
+namespace
+{
+    constexpr size_t kBatch = 1024;
+
+    std::vector<sf::FloatRect> makeLevel(size_t count, float side)
+    {
+        std::mt19937 random(42);
+        std::uniform_real_distribution<float> position(-side / 2, side / 2);
+        std::uniform_real_distribution<float> size(50, 400);
+
+        std::vector<sf::FloatRect> blocks;
+        while (blocks.size() < count)
+            blocks.push_back({position(random), position(random), size(random), size(random)});
+        return blocks;
+    }
+
+    bool overlaps(const sf::FloatRect &a, const sf::FloatRect &b)
+    {
+        return a.left <= b.left + b.width && b.left <= a.left + a.width &&
+               a.top <= b.top + b.height && b.top <= a.top + a.height;
+    }
+
+    // First block along a ray, testing every block.
+    float scanRay(const std::vector<sf::FloatRect> &blocks, const BlockBvh::Ray &ray)
+    {
+        float best = 1;
+        for (const sf::FloatRect &block : blocks)
+        {
+            float entry = 0, exit = best;
+            const float origin[2] = {ray.origin.x, ray.origin.y};
+            const float delta[2] = {ray.delta.x, ray.delta.y};
+            const float min[2] = {block.left, block.top};
+            const float max[2] = {block.left + block.width, block.top + block.height};
+            for (int axis = 0; axis < 2 && entry <= exit; ++axis)
+            {
+                if (delta[axis] == 0)
+                {
+                    if (origin[axis] < min[axis] || origin[axis] > max[axis])
+                        exit = -1;
+                    continue;
+                }
+                float first = (min[axis] - origin[axis]) / delta[axis];
+                float second = (max[axis] - origin[axis]) / delta[axis];
+                entry = std::max(entry, std::min(first, second));
+                exit = std::min(exit, std::max(first, second));
+            }
+            if (entry <= exit)
+                best = entry;
+        }
+        return best;
+    }
+}
+
+int main()
+{
+    for (size_t count : {10'000, 100'000, 1'000'000})
+    {
+        // About one block per 600x600 area, whatever the level size.
+        float side = std::sqrt(static_cast<float>(count)) * 600;
+        std::vector<sf::FloatRect> blocks = makeLevel(count, side);
+        std::string suffix = ", " + std::to_string(count) + " blocks";
+
+        BlockBvh bvh;
+        double ns = bench::measure(1, [&](size_t) { bvh.build(blocks); });
+        bench::report("build" + suffix, ns);
+
+        std::mt19937 random(7);
+        std::uniform_real_distribution<float> position(-side / 2, side / 2);
+        std::uniform_real_distribution<float> offset(-1000, 1000);
+        std::vector<sf::FloatRect> areas;
+        std::vector<BlockBvh::Ray> probes, sightLines;
+        std::vector<BlockBvh::Sweep> sweeps;
+        for (size_t i = 0; i < kBatch; ++i)
+        {
+            sf::Vector2f point{position(random), position(random)};
+            areas.push_back({point.x - 100, point.y - 100, 200, 200});
+            probes.push_back({point, {0, 300}});
+            sightLines.push_back({point, {offset(random), offset(random)}});
+            sweeps.push_back({{point.x - 20, point.y - 60, 40, 120}, {30, 60}});
+        }
+
+        std::vector<std::uint32_t> found, offsets;
+        std::vector<BlockBvh::Hit> hits;
+        size_t iterations = count >= 1'000'000 ? 20 : 200;
+
+        ns = bench::measure(iterations, [&](size_t) {
+            bvh.overlap(areas, found, offsets);
+            bench::do_not_optimize(found.data());
+        });
+        bench::report("overlap batch" + suffix, ns / kBatch);
+        ns = bench::measure(iterations, [&](size_t) {
+            bvh.castRays(probes, hits);
+            bench::do_not_optimize(hits.data());
+        });
+        bench::report("ground probe batch" + suffix, ns / kBatch);
+        ns = bench::measure(iterations, [&](size_t) {
+            bvh.castRays(sightLines, hits);
+            bench::do_not_optimize(hits.data());
+        });
+        bench::report("line of sight batch" + suffix, ns / kBatch);
+        ns = bench::measure(iterations, [&](size_t) {
+            bvh.sweep(sweeps, hits);
+            bench::do_not_optimize(hits.data());
+        });
+        bench::report("swept box batch" + suffix, ns / kBatch);
+
+        if (count > 100'000)
+            continue;
+
+        ns = bench::measure(2, [&](size_t) {
+            for (const sf::FloatRect &area : areas)
+            {
+                found.clear();
+                for (std::uint32_t index = 0; index < blocks.size(); ++index)
+                    if (overlaps(area, blocks[index]))
+                        found.push_back(index);
+                bench::do_not_optimize(found.data());
+            }
+        });
+        bench::report("overlap scan" + suffix, ns / kBatch);
+        ns = bench::measure(2, [&](size_t) {
+            for (const BlockBvh::Ray &ray : sightLines)
+                bench::do_not_optimize(scanRay(blocks, ray));
+        });
+        bench::report("line of sight scan" + suffix, ns / kBatch);
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+// g++ -std=c++17 -O2 -pthread crowd_bench.cpp -o crowd_bench -lsfml-graphics -lsfml-window -lsfml-system
+//
+// Run from State/ so that Characters finds images/hero.png.
+//
+// Per-character cost of the crowd passes of World::update, for 1k to 100k
+// characters spread over a floor with some blocks on it: gravity and
+// integration, which only walk the float arrays, and collision, which
+// queries the spatial hash per character.
+#include "../State/characters.hpp"
+#include "bench.hpp"
+#include <random>
+#include <string>
+
+int main()
+{
+    const float dt = 1.0f / 60;
+    const float gravity = 3600;
+
+    for (size_t count : {1'000, 10'000, 100'000})
+    {
+        float width = static_cast<float>(count) * 100;
+        std::vector<sf::FloatRect> blocks{{-500, 770, width + 1000, 400}};
+        std::mt19937 random(42);
+        std::uniform_real_distribution<float> position(0, width);
+        while (blocks.size() < count / 10)
+            blocks.push_back({position(random), 570, 300, 200});
+
+        SpatialHash grid;
+        for (size_t i = 0; i < blocks.size(); ++i)
+            grid.insert(blocks[i], static_cast<std::uint32_t>(i));
+
+        Characters characters;
+        for (size_t i = 0; i < count; ++i)
+            characters.add({static_cast<float>(i) * 100, 0});
+        // Let everyone land first.
+        for (int tick = 0; tick < 120; ++tick)
+        {
+            characters.applyGravity(gravity, dt);
+            characters.integrate(dt);
+            characters.collide(blocks, grid);
+        }
+
+        std::string suffix = ", " + std::to_string(count) + " characters";
+        double ns = bench::measure(1'000, [&](size_t) {
+            characters.applyGravity(gravity, dt);
+            characters.integrate(dt);
+        });
+        bench::report("gravity + integration" + suffix, ns / count);
+        ns = bench::measure(100, [&](size_t) { characters.collide(blocks, grid); });
+        bench::report("collision" + suffix, ns / count);
+    }
+    return 0;
+}
@@ -0,0 +1,61 @@
+// g++ -std=c++17 -O2 make_shared_bench.cpp -o make_shared_bench
+#include "../sharedptr.cpp"
+#include "bench.hpp"
+#include <vector>
+
+struct Particle
+{
+    float x, y, vx, vy;
+    Particle(float x, float y) : x(x), y(y), vx(0), vy(0) {}
+};
+
+int main()
+{
+    const size_t kIterations = 2'000'000;
+    const size_t kBatch = 4096;
+
+    auto separate = [](size_t i)
+    {
+        custom_classes::shared_ptr<Particle> p(new Particle(i, i));
+        bench::do_not_optimize(p->x);
+    };
+    auto fused = [](size_t i)
+    {
+        auto p = custom_classes::make_shared<Particle>(i, i);
+        bench::do_not_optimize(p->x);
+    };
+    bench::report("shared_ptr(new T) create+destroy", bench::measure(kIterations, separate));
+    bench::report("make_shared<T> create+destroy", bench::measure(kIterations, fused));
+
+    // Many live objects per "frame": allocations interleave and the control
+    // block of the two-allocation path ends up away from its object.
+    std::vector<custom_classes::shared_ptr<Particle>> frame;
+    frame.reserve(kBatch);
+
+    auto touch_frame = [&]()
+    {
+        float sum = 0;
+        for (auto &p : frame)
+            sum += p->x + p.use_count();
+        bench::do_not_optimize(sum);
+        frame.clear();
+    };
+    auto separate_frame = [&](size_t)
+    {
+        for (size_t i = 0; i < kBatch; ++i)
+            frame.push_back(custom_classes::shared_ptr<Particle>(new Particle(i, i)));
+        touch_frame();
+    };
+    auto fused_frame = [&](size_t)
+    {
+        for (size_t i = 0; i < kBatch; ++i)
+            frame.push_back(custom_classes::make_shared<Particle>(i, i));
+        touch_frame();
+    };
+    bench::report("shared_ptr(new T) frame of 4096",
+                  bench::measure(kIterations / kBatch, separate_frame) / kBatch);
+    bench::report("make_shared<T> frame of 4096",
+                  bench::measure(kIterations / kBatch, fused_frame) / kBatch);
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+// g++ -std=c++17 -O2 overlap_kernel_bench.cpp -o overlap_kernel_bench -lsfml-graphics -lsfml-window -lsfml-system
+//
+// Add -mavx2 or -mavx512f to try the wider kernels. Run from State/ so that
+// Player finds images/hero.png.
+//
+// Full collision scans of a Player against 1k to 100k blocks, once with the
+// scalar loop over sf::FloatRect and once with the SIMD kernel over
+// BlockColumns. Two players are stepped side by side through a fall across
+// the level first, and any difference in where they end up is reported.
+// A third player finds the blocks near it with the spatial hash and gathers
+// them into BlockColumns for the scan. That is timed against the scalar
+// loop over the same candidates, which World::update uses: with the few
+// blocks near a player in a real level, the gather costs more than the
+// SIMD scan saves.
+#include "../State/player.cpp"
+#include "../State/player_states.cpp"
+#include "../State/spatial_hash.hpp"
+#include "bench.hpp"
+#include <cstring>
+#include <random>
+#include <string>
+
+namespace
+{
+    std::vector<sf::FloatRect> makeLevel(size_t count)
+    {
+        std::mt19937 random(42);
+        std::uniform_real_distribution<float> position(-20000, 20000);
+        std::uniform_real_distribution<float> size(50, 400);
+
+        std::vector<sf::FloatRect> blocks;
+        blocks.push_back({-500, 770, 20000, 400});
+        while (blocks.size() < count)
+            blocks.push_back({position(random), position(random), size(random), size(random)});
+        return blocks;
+    }
+
+    bool sameBits(sf::Vector2f a, sf::Vector2f b) { return std::memcmp(&a, &b, sizeof(a)) == 0; }
+}
+
+int main()
+{
+    const float dt = 1.0f / 60;
+    const std::vector<std::uint32_t> noCandidates;
+
+    for (size_t count : {1'000, 10'000, 100'000})
+    {
+        std::vector<sf::FloatRect> blocks = makeLevel(count);
+        BlockColumns columns(blocks);
+        SpatialHash grid;
+        for (size_t i = 0; i < blocks.size(); ++i)
+            grid.insert(blocks[i], static_cast<std::uint32_t>(i));
+        std::string suffix = ", " + std::to_string(count) + " blocks";
+
+        Player scalar({400, -3000});
+        Player simd({400, -3000});
+        Player nearby({400, -3000});
+        std::vector<std::uint32_t> candidates;
+        BlockColumns nearbyColumns;
+        auto queryNear = [&](const Player &player) {
+            sf::FloatRect area = player.getSweptBounds();
+            sf::FloatRect bounds = player.getCollisionBounds();
+            float margin = 2 * std::max(bounds.width, bounds.height);
+            grid.query({area.left - margin, area.top - margin, area.width + 2 * margin,
+                        area.height + 2 * margin},
+                       candidates);
+        };
+        size_t mismatches = 0;
+        for (int tick = 0; tick < 600; ++tick)
+        {
+            for (Player *player : {&scalar, &simd, &nearby})
+            {
+                player->applyVelocity({tick % 120 < 60 ? 20.f : -20.f, 3600 * dt});
+                player->update(dt);
+                player->move(blocks, noCandidates);
+            }
+            scalar.handleAllCollisions(blocks);
+            simd.handleAllCollisions(columns);
+            queryNear(nearby);
+            nearbyColumns.assign(columns, candidates);
+            nearby.handleAllCollisions(nearbyColumns);
+            if (!sameBits(scalar.getCenter(), simd.getCenter()) ||
+                !sameBits(scalar.getCenter(), nearby.getCenter()))
+                ++mismatches;
+        }
+        std::printf("%-40s %10zu\n", ("mismatched ticks" + suffix).c_str(), mismatches);
+
+        size_t iterations = 10'000'000 / count;
+        double ns = bench::measure(iterations, [&](size_t) {
+            scalar.handleAllCollisions(blocks);
+            bench::do_not_optimize(scalar);
+        });
+        bench::report("scalar scan" + suffix, ns);
+        ns = bench::measure(iterations, [&](size_t) {
+            simd.handleAllCollisions(columns);
+            bench::do_not_optimize(simd);
+        });
+        bench::report("SIMD scan" + suffix, ns);
+
+        queryNear(nearby);
+        ns = bench::measure(iterations, [&](size_t) {
+            nearby.handleAllCollisions(blocks, candidates);
+            bench::do_not_optimize(nearby);
+        });
+        bench::report("scalar scan of candidates" + suffix, ns);
+        ns = bench::measure(iterations, [&](size_t) {
+            nearbyColumns.assign(columns, candidates);
+            nearby.handleAllCollisions(nearbyColumns);
+            bench::do_not_optimize(nearby);
+        });
+        bench::report("gather + SIMD scan of candidates" + suffix, ns);
+    }
+    return 0;
+}
@@ -0,0 +1,80 @@
+// g++ -std=c++17 -O2 -pthread parallel_update_bench.cpp -o parallel_update_bench -lsfml-graphics -lsfml-window -lsfml-system
+//
+// Run from State/ so that Characters finds images/hero.png.
+//
+// Tick time of Characters::update for a crowd of 100k with 1, 2, 4 and all
+// hardware threads. Every run starts from the same crowd, and the final
+// positions and states are compared bit for bit with the single-threaded
+// run, since the merge step is meant to make the thread count invisible.
+#include "../State/characters.hpp"
+#include "bench.hpp"
+#include <cstring>
+#include <random>
+#include <string>
+
+namespace
+{
+    constexpr size_t kCharacters = 100'000;
+    constexpr int kTicks = 120;
+
+    void fill(Characters &characters)
+    {
+        for (size_t i = 0; i < kCharacters; ++i)
+            characters.add({static_cast<float>(i) * 100, static_cast<float>(i % 7) * -150});
+    }
+
+    size_t differences(const Characters &a, const Characters &b)
+    {
+        size_t count = 0;
+        for (std::uint32_t i = 0; i < a.size(); ++i)
+        {
+            sf::Vector2f first = a.getPosition(i);
+            sf::Vector2f second = b.getPosition(i);
+            if (std::memcmp(&first, &second, sizeof(first)) != 0 ||
+                a.getState(i) != b.getState(i))
+                ++count;
+        }
+        return count;
+    }
+}
+
+int main()
+{
+    const float dt = 1.0f / 60;
+    const float gravity = 3600;
+
+    float width = static_cast<float>(kCharacters) * 100;
+    std::vector<sf::FloatRect> blocks{{-500, 770, width + 1000, 400}};
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> position(0, width);
+    while (blocks.size() < kCharacters / 10)
+        blocks.push_back({position(random), 570, 300, 200});
+    SpatialHash grid;
+    for (size_t i = 0; i < blocks.size(); ++i)
+        grid.insert(blocks[i], static_cast<std::uint32_t>(i));
+
+    Characters reference;
+    fill(reference);
+
+    std::vector<size_t> threadCounts{1, 2, 4};
+    if (JobSystem::defaultThreadCount() > 4)
+        threadCounts.push_back(JobSystem::defaultThreadCount());
+
+    for (size_t threads : threadCounts)
+    {
+        JobSystem jobs(threads);
+        Characters characters;
+        fill(characters);
+        double ns = bench::measure(kTicks, [&](size_t) {
+            characters.update(gravity, dt, blocks, grid, jobs);
+        });
+        bench::report("update, " + std::to_string(threads) + " threads", ns);
+
+        if (threads == 1)
+            reference = characters;
+        else
+            std::printf("%-40s %10zu\n", "  characters differing from 1 thread",
+                        differences(reference, characters));
+    }
+    return 0;
+}
@@ -0,0 +1,81 @@
+// g++ -std=c++17 -O2 player_transition_bench.cpp -o player_transition_bench -lsfml-graphics -lsfml-window -lsfml-system
+//
+// Run from State/ so that Player finds images/hero.png.
+//
+// Drives a real Player through a loop of eight state transitions using only
+// its public interface (collisions and key events), and counts heap
+// allocations made while doing so. Also times the common per-tick case of an
+// event the current state ignores: an idle player standing on the ground.
+#include "../State/player.cpp"
+#include "../State/player_states.cpp"
+#include "bench.hpp"
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    size_t gAllocations = 0;
+
+    sf::Event keyEvent(sf::Event::EventType type, sf::Keyboard::Key code)
+    {
+        sf::Event event;
+        event.type = type;
+        event.key.code = code;
+        return event;
+    }
+}
+
+void *operator new(size_t size)
+{
+    void *ptr = std::malloc(size);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    ++gAllocations;
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+
+int main()
+{
+    constexpr size_t kIterations = 1'000'000;
+    constexpr size_t kTransitionsPerIteration = 8;
+
+    Player player({400, 400});
+    const std::vector<sf::FloatRect> noBlocks;
+    const sf::Event shiftPressed = keyEvent(sf::Event::KeyPressed, sf::Keyboard::LShift);
+    const sf::Event shiftReleased = keyEvent(sf::Event::KeyReleased, sf::Keyboard::LShift);
+    const sf::Event leftPressed = keyEvent(sf::Event::KeyPressed, sf::Keyboard::Left);
+    const sf::Event leftReleased = keyEvent(sf::Event::KeyReleased, sf::Keyboard::Left);
+
+    size_t allocationsBefore = gAllocations;
+    double ns = bench::measure(kIterations, [&](size_t) {
+        player.handleAllCollisions(noBlocks); // Idle -> Falling
+        sf::Vector2f center = player.getCenter();
+        // Overlaps the player's feet by one unit: Falling -> Idle.
+        player.handleCollision({center.x - 1000, center.y + 59, 2000, 100});
+        player.handleEvents(shiftPressed);  // Idle -> Sitting
+        player.handleEvents(shiftReleased); // Sitting -> Idle
+        player.handleEvents(leftPressed);   // Idle -> Running
+        player.handleEvents(shiftPressed);  // Running -> Sliding
+        player.handleEvents(leftPressed);   // Sliding -> Running
+        player.handleEvents(leftReleased);  // Running -> Idle
+        bench::do_not_optimize(player);
+    });
+    size_t allocations = gAllocations - allocationsBefore;
+
+    bench::report("player state transition", ns / kTransitionsPerIteration);
+    std::printf("%-40s %10.3f\n", "heap allocations per transition",
+                static_cast<double>(allocations) / (kIterations * kTransitionsPerIteration));
+
+    sf::Vector2f center = player.getCenter();
+    const std::vector<sf::FloatRect> ground{{center.x - 1000, center.y + 59, 2000, 100}};
+    ns = bench::measure(kIterations, [&](size_t) {
+        player.handleAllCollisions(ground); // hitGround, ignored by Idle
+        bench::do_not_optimize(player);
+    });
+    bench::report("ignored event (idle on ground)", ns);
+    return 0;
+}
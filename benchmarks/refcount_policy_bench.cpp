@@ -0,0 +1,116 @@
+// g++ -std=c++17 -O2 -pthread refcount_policy_bench.cpp -o refcount_policy_bench
+#include "../sharedptr.cpp"
+#include "bench.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+struct Config
+{
+    static std::atomic<size_t> destroyed;
+
+    int value{42};
+
+    ~Config() { destroyed.fetch_add(1, std::memory_order_relaxed); }
+};
+
+std::atomic<size_t> Config::destroyed{0};
+
+// Every thread repeatedly copies a pointer from a shared source and drops the
+// copy. Thread 0 is the creating (owner) thread.
+template <typename Policy>
+double copy_destroy_throughput(unsigned thread_count, size_t iterations)
+{
+    auto source = custom_classes::make_shared<Config, Policy>();
+
+    auto work = [&source, iterations]()
+    {
+        int sum = 0;
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            custom_classes::shared_ptr<Config, Policy> copy(source);
+            sum += copy->value;
+        }
+        bench::do_not_optimize(sum);
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < thread_count; ++t)
+        workers.emplace_back(work);
+    work();
+    for (auto &worker : workers)
+        worker.join();
+    auto stop = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(stop - start).count();
+    return thread_count * iterations / seconds / 1e6;
+}
+
+// The owner creates an object, copies the pointer, drops the original and
+// hands the copy to a worker, which drops the last reference. Exits if any
+// object is left alive afterwards.
+template <typename Policy>
+double handoff_throughput(size_t iterations)
+{
+    std::vector<custom_classes::shared_ptr<Config, Policy>> copies;
+    copies.reserve(iterations);
+    size_t destroyed_before = Config::destroyed.load();
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        auto original = custom_classes::make_shared<Config, Policy>();
+        copies.push_back(original);
+    }
+    std::thread worker([&copies] { copies.clear(); });
+    worker.join();
+    if constexpr (std::is_same<Policy, custom_classes::biased_policy>::value)
+        Policy::merge_pending();
+    auto stop = std::chrono::steady_clock::now();
+
+    if (Config::destroyed.load() - destroyed_before != iterations)
+    {
+        std::printf("handoff leaked %zu objects\n",
+                    iterations - (Config::destroyed.load() - destroyed_before));
+        std::exit(1);
+    }
+    double seconds = std::chrono::duration<double>(stop - start).count();
+    return iterations / seconds / 1e6;
+}
+
+template <typename Policy>
+void run(const char *name, unsigned max_threads, size_t iterations)
+{
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2)
+        std::printf("%-10s threads=%-3u %10.2f Mops/s\n", name, threads,
+                    copy_destroy_throughput<Policy>(threads, iterations));
+}
+
+template <typename Policy>
+void run_handoff(const char *name, size_t iterations)
+{
+    std::printf("%-10s handoff     %10.2f Mops/s\n", name,
+                handoff_throughput<Policy>(iterations));
+}
+
+int main()
+{
+    const size_t kIterations = 5'000'000;
+    unsigned max_threads = std::max(4u, std::thread::hardware_concurrency());
+
+    // The non-atomic policy is only valid on a single thread; it is the
+    // baseline for the game loop.
+    run<custom_classes::nonatomic_policy>("nonatomic", 1, kIterations);
+    run<custom_classes::atomic_policy>("atomic", max_threads, kIterations);
+    run<custom_classes::biased_policy>("biased", max_threads, kIterations);
+
+    // Objects whose last reference is dropped off the owner thread.
+    const size_t kHandoffs = 1'000'000;
+    run_handoff<custom_classes::atomic_policy>("atomic", kHandoffs);
+    run_handoff<custom_classes::biased_policy>("biased", kHandoffs);
+
+    return 0;
+}
@@ -0,0 +1,140 @@
+// g++ -std=c++17 -O2 skilltree_bench.cpp -o skilltree_bench
+//
+// Builds large generated trees with the node layout of skilltree.cpp, once
+// with std::shared_ptr children (as before) and once with intrusive_ptr.
+// The real nodes need SFML, so the stand-ins keep only what affects the
+// pointer cost: a vtable, a position, a state and the children vector.
+#include "../intrusiveptr.cpp"
+#include "bench.hpp"
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace
+{
+    size_t gAllocations = 0;
+    size_t gLiveBytes = 0;
+
+    struct alignas(std::max_align_t) AllocationHeader
+    {
+        size_t size;
+    };
+}
+
+void *operator new(size_t size)
+{
+    auto *header = static_cast<AllocationHeader *>(std::malloc(sizeof(AllocationHeader) + size));
+    if (header == nullptr)
+        throw std::bad_alloc();
+    header->size = size;
+    ++gAllocations;
+    gLiveBytes += size;
+    return header + 1;
+}
+
+void operator delete(void *ptr) noexcept
+{
+    if (ptr == nullptr)
+        return;
+    auto *header = static_cast<AllocationHeader *>(ptr) - 1;
+    gLiveBytes -= header->size;
+    std::free(header);
+}
+
+void operator delete(void *ptr, size_t) noexcept { operator delete(ptr); }
+
+struct SharedNode
+{
+    virtual ~SharedNode() = default;
+    virtual size_t getNodeStatus() const
+    {
+        size_t sum = 0;
+        for (auto &child : mChildren)
+            sum += child->getNodeStatus();
+        return sum + state;
+    }
+    void addChild(const std::shared_ptr<SharedNode> &child) { mChildren.push_back(child); }
+
+    float x{0}, y{0};
+    int state{1};
+    std::vector<std::shared_ptr<SharedNode>> mChildren{};
+};
+
+struct IntrusiveNode : custom_classes::ref_counted
+{
+    virtual size_t getNodeStatus() const
+    {
+        size_t sum = 0;
+        for (auto &child : mChildren)
+            sum += child->getNodeStatus();
+        return sum + state;
+    }
+    void addChild(const custom_classes::intrusive_ptr<IntrusiveNode> &child)
+    {
+        mChildren.push_back(child);
+    }
+
+    float x{0}, y{0};
+    int state{1};
+    std::vector<custom_classes::intrusive_ptr<IntrusiveNode>> mChildren{};
+};
+
+// Complete tree with the given fan-out, built top-down the way the skill
+// trees are: create a child, hand it to addChild, keep a copy to descend.
+template <typename Node, typename Ptr>
+Ptr generate(size_t node_count, size_t fanout)
+{
+    Ptr root{new Node()};
+    std::vector<Ptr> frontier{root};
+    size_t created = 1;
+    for (size_t next = 0; created < node_count; ++next)
+    {
+        Ptr parent = frontier[next];
+        for (size_t i = 0; i < fanout && created < node_count; ++i, ++created)
+        {
+            Ptr child{new Node()};
+            parent->addChild(child);
+            frontier.push_back(child);
+        }
+    }
+    return root;
+}
+
+template <typename Node, typename Ptr>
+void run(const char *name, size_t node_count)
+{
+    size_t allocations_before = gAllocations;
+    size_t bytes_before = gLiveBytes;
+
+    auto start = std::chrono::steady_clock::now();
+    Ptr root = generate<Node, Ptr>(node_count, 3);
+    auto built = std::chrono::steady_clock::now();
+
+    size_t allocations = gAllocations - allocations_before;
+    size_t bytes = gLiveBytes - bytes_before;
+
+    size_t status = root->getNodeStatus();
+    bench::do_not_optimize(status);
+    auto traversed = std::chrono::steady_clock::now();
+
+    root = Ptr();
+    auto destroyed = std::chrono::steady_clock::now();
+
+    using ms = std::chrono::duration<double, std::milli>;
+    std::printf("%-14s nodes=%-8zu build %8.2f ms  traverse %7.2f ms  destroy %7.2f ms  "
+                "allocs %8zu  bytes/node %6.1f\n",
+                name, node_count, ms(built - start).count(), ms(traversed - built).count(),
+                ms(destroyed - traversed).count(), allocations,
+                static_cast<double>(bytes) / node_count);
+}
+
+int main()
+{
+    for (size_t nodes : {1'000ul, 100'000ul, 1'000'000ul})
+    {
+        run<SharedNode, std::shared_ptr<SharedNode>>("std::shared_ptr", nodes);
+        run<IntrusiveNode, custom_classes::intrusive_ptr<IntrusiveNode>>("intrusive_ptr", nodes);
+    }
+    return 0;
+}
@@ -0,0 +1,155 @@
+// g++ -std=c++17 -O2 smartptr_suite.cpp -o smartptr_suite
+// ./smartptr_suite [element_count] > report.json
+//
+// Runs the same workloads over the custom smart pointers and their standard
+// library counterparts. A JSON report goes to stdout, a readable table to
+// stderr.
+#include "../sharedptr.cpp"
+#include "../uniqueptr.cpp"
+#include "bench.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+    struct Result
+    {
+        std::string type;
+        std::string workload;
+        size_t elements;
+        double ns_per_element;
+    };
+
+    std::vector<Result> gResults;
+
+    void record(const char *type, const char *workload, size_t elements, double ns)
+    {
+        gResults.push_back({type, workload, elements, ns / elements});
+        std::fprintf(stderr, "%-28s %-12s %10.2f ns/element\n", type, workload, ns / elements);
+    }
+
+    template <typename Body>
+    double time_once(Body &&body)
+    {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        auto stop = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(stop - start).count();
+    }
+
+    // `make(value)` creates a handle whose first element is `value`; every
+    // handle type exposes it as *get().
+    template <typename Handle, bool copyable, typename Make>
+    void run_suite(const char *type, size_t count, Make make)
+    {
+        std::mt19937 random(42);
+        std::vector<int> values(count);
+        for (int &value : values)
+            value = static_cast<int>(random());
+
+        std::vector<Handle> handles;
+        handles.reserve(count);
+        auto construct = [&]()
+        {
+            for (int value : values)
+                handles.push_back(make(value));
+        };
+        record(type, "construct", count, time_once(construct));
+
+        if constexpr (copyable)
+        {
+            std::vector<Handle> copies;
+            copies.reserve(count);
+            auto copy = [&]()
+            {
+                for (const Handle &handle : handles)
+                    copies.push_back(handle);
+            };
+            record(type, "copy", count, time_once(copy));
+        }
+
+        std::vector<Handle> moved;
+        moved.reserve(count);
+        auto move = [&]()
+        {
+            for (Handle &handle : handles)
+                moved.push_back(std::move(handle));
+        };
+        record(type, "move", count, time_once(move));
+        handles.swap(moved);
+        moved.clear();
+
+        const size_t kPasses = 10;
+        auto deref_loop = [&]()
+        {
+            long sum = 0;
+            for (size_t pass = 0; pass < kPasses; ++pass)
+                for (const Handle &handle : handles)
+                    sum += *handle.get();
+            bench::do_not_optimize(sum);
+        };
+        record(type, "deref_loop", count * kPasses, time_once(deref_loop));
+
+        auto sort = [&]()
+        {
+            std::sort(handles.begin(), handles.end(), [](const Handle &a, const Handle &b)
+                      { return *a.get() < *b.get(); });
+        };
+        record(type, "sort", count, time_once(sort));
+
+        auto destroy = [&]()
+        { handles.clear(); };
+        record(type, "destroy", count, time_once(destroy));
+    }
+
+    template <typename Array>
+    Array make_array(int value)
+    {
+        Array array(new int[4]{value, 0, 0, 0});
+        return array;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1'000'000;
+
+    run_suite<custom_classes::unique_ptr<int>, false>(
+        "custom::unique_ptr<int>", count, [](int v)
+        { return custom_classes::unique_ptr<int>(new int(v)); });
+    run_suite<std::unique_ptr<int>, false>(
+        "std::unique_ptr<int>", count, [](int v)
+        { return std::make_unique<int>(v); });
+
+    run_suite<custom_classes::unique_ptr<int[]>, false>(
+        "custom::unique_ptr<int[]>", count, make_array<custom_classes::unique_ptr<int[]>>);
+    run_suite<std::unique_ptr<int[]>, false>(
+        "std::unique_ptr<int[]>", count, make_array<std::unique_ptr<int[]>>);
+
+    run_suite<custom_classes::shared_ptr<int>, true>(
+        "custom::shared_ptr<int>", count, [](int v)
+        { return custom_classes::make_shared<int>(v); });
+    run_suite<std::shared_ptr<int>, true>(
+        "std::shared_ptr<int>", count, [](int v)
+        { return std::make_shared<int>(v); });
+
+    run_suite<custom_classes::shared_ptr<int *>, true>(
+        "custom::shared_ptr<int*>", count, make_array<custom_classes::shared_ptr<int *>>);
+    run_suite<std::shared_ptr<int[]>, true>(
+        "std::shared_ptr<int[]>", count, make_array<std::shared_ptr<int[]>>);
+
+    std::printf("{\n  \"elements\": %zu,\n  \"results\": [\n", count);
+    for (size_t i = 0; i < gResults.size(); ++i)
+    {
+        const Result &r = gResults[i];
+        std::printf("    {\"type\": \"%s\", \"workload\": \"%s\", \"elements\": %zu, "
+                    "\"ns_per_element\": %.3f}%s\n",
+                    r.type.c_str(), r.workload.c_str(), r.elements, r.ns_per_element,
+                    i + 1 == gResults.size() ? "" : ",");
+    }
+    std::printf("  ]\n}\n");
+    return 0;
+}
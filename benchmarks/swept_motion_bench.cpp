@@ -0,0 +1,61 @@
+// g++ -std=c++17 -O2 swept_motion_bench.cpp -o swept_motion_bench -lsfml-graphics -lsfml-window -lsfml-system
+//
+// Run from State/ so that Player finds images/hero.png.
+//
+// Walks a Player along a floor made of level 500-wide blocks, the way level
+// floors are built, and checks that it crosses every seam between them
+// instead of snagging on the next block's side. Then times Player::move
+// plus handleAllCollisions per tick on that floor.
+#include "../State/player.cpp"
+#include "../State/player_states.cpp"
+#include "bench.hpp"
+#include <cstdlib>
+
+int main()
+{
+    const float dt = 1.0f / 60;
+    const float speed = 600;
+    const size_t kTiles = 20;
+
+    std::vector<sf::FloatRect> blocks;
+    std::vector<std::uint32_t> candidates;
+    for (size_t i = 0; i < kTiles; ++i)
+    {
+        blocks.push_back({static_cast<float>(i) * 500, 1000, 500, 100});
+        candidates.push_back(static_cast<std::uint32_t>(i));
+    }
+
+    // Held-down walking: the horizontal velocity only lasts for one step.
+    auto step = [&](Player &player) {
+        player.applyVelocity({speed, 3600 * dt});
+        player.update(dt);
+        player.move(blocks, candidates);
+        player.handleAllCollisions(blocks, candidates);
+        player.applyVelocity({-speed, 0});
+    };
+
+    Player walker({100, 939});
+    int ticks = static_cast<int>((kTiles - 1) * 500 / (speed * dt));
+    for (int tick = 0; tick < ticks; ++tick)
+        step(walker);
+    size_t crossed = static_cast<size_t>(walker.getCenter().x / 500);
+    std::printf("%-40s %7zu of %zu\n", "seams crossed", crossed, kTiles - 1);
+    if (crossed < kTiles - 1)
+    {
+        std::printf("player stopped at x = %f\n", walker.getCenter().x);
+        return 1;
+    }
+
+    const int kRuns = 200;
+    double ns = 0;
+    for (int run = 0; run < kRuns; ++run)
+    {
+        Player player({100, 939});
+        ns += bench::measure(ticks, [&](size_t) {
+            step(player);
+            bench::do_not_optimize(player);
+        });
+    }
+    bench::report("walking tick, 20 blocks", ns / kRuns);
+    return 0;
+}
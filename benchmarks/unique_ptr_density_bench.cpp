@@ -0,0 +1,57 @@
+// g++ -std=c++17 -O2 unique_ptr_density_bench.cpp -o unique_ptr_density_bench
+//
+// Walks large vectors of unique_ptr handles. The compressed layout keeps a
+// stateless deleter out of the handle; `padded_delete` reproduces the old
+// layout, where the deleter was a member and padded every handle to two words.
+#include "../uniqueptr.cpp"
+#include "bench.hpp"
+#include <memory>
+#include <vector>
+
+struct Entity
+{
+    float x, y;
+};
+
+template <typename data_t>
+struct padded_delete
+{
+    char unused_{0};
+    void operator()(data_t *ptr) noexcept { delete ptr; }
+};
+
+static_assert(sizeof(custom_classes::unique_ptr<Entity>) == sizeof(Entity *));
+static_assert(sizeof(custom_classes::unique_ptr<Entity, padded_delete<Entity>>) ==
+              2 * sizeof(Entity *));
+
+template <typename Handle>
+void run(const char *name, size_t count)
+{
+    std::vector<Handle> handles;
+    handles.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+        handles.emplace_back(new Entity{static_cast<float>(i), 1.0f});
+
+    const size_t kPasses = 20;
+    double ns = bench::measure(kPasses, [&](size_t)
+                               {
+                                   float sum = 0;
+                                   for (const auto &handle : handles)
+                                       sum += handle->x;
+                                   bench::do_not_optimize(sum);
+                               });
+    std::printf("%-30s count=%-9zu handle=%2zu B  vector=%7.1f MiB  %6.3f ns/element\n",
+                name, count, sizeof(Handle), count * sizeof(Handle) / 1048576.0, ns / count);
+}
+
+int main()
+{
+    for (size_t count : {100'000ul, 1'000'000ul, 8'000'000ul})
+    {
+        run<custom_classes::unique_ptr<Entity>>("unique_ptr (compressed)", count);
+        run<custom_classes::unique_ptr<Entity, padded_delete<Entity>>>("unique_ptr (member deleter)",
+                                                                        count);
+        run<std::unique_ptr<Entity>>("std::unique_ptr", count);
+    }
+    return 0;
+}
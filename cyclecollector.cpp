@@ -0,0 +1,224 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "sharedptr.cpp"
+
+namespace custom_classes
+{
+
+    template <typename Policy = nonatomic_policy>
+    class cycle_tracer;
+
+    template <typename Policy = nonatomic_policy>
+    class cycle_collector;
+
+    // Base for objects that can take part in a reference cycle. trace()
+    // must pass every shared_ptr member to the tracer:
+    //
+    //     void trace(cycle_tracer<> &tracer) override
+    //     {
+    //         tracer(parent_);
+    //         for (auto &child : children_)
+    //             tracer(child);
+    //     }
+    //
+    // Members that are not reported look like references from outside the
+    // graph, which only keeps more objects alive than necessary.
+    template <typename Policy = nonatomic_policy>
+    class traceable
+    {
+    public:
+        virtual ~traceable() = default;
+        virtual void trace(cycle_tracer<Policy> &tracer) = 0;
+    };
+
+    template <typename Policy>
+    class cycle_tracer
+    {
+    public:
+        template <typename data_t>
+        void operator()(shared_ptr<data_t, Policy> &edge)
+        {
+            if (pass_ == pass::clear)
+            {
+                edge = shared_ptr<data_t, Policy>();
+                return;
+            }
+            if constexpr (std::is_base_of<traceable<Policy>, data_t>::value)
+            {
+                if (edge.get() != nullptr)
+                    collector_.visit_edge(static_cast<traceable<Policy> *>(edge.get()), pass_);
+            }
+        }
+
+    private:
+        enum class pass
+        {
+            subtract,
+            mark,
+            clear
+        };
+
+        cycle_tracer(cycle_collector<Policy> &collector, pass current) noexcept
+            : collector_(collector), pass_(current) {}
+
+        cycle_collector<Policy> &collector_;
+        pass pass_;
+
+        friend class cycle_collector<Policy>;
+    };
+
+    // Finds and frees groups of tracked objects that only keep each other
+    // alive, by trial deletion: every reference from one tracked object to
+    // another is subtracted from the target's strong count. Objects left
+    // with a positive count are referenced from outside; they and everything
+    // they reach survive. The rest is garbage. Its edges are reset first, so
+    // no destructor sees a half-destroyed neighbour.
+    //
+    // Nothing runs on its own. The game loop calls collect() where a pause
+    // is acceptable, e.g. on level change or every few seconds. Not
+    // thread-safe; the graph must not change during collect().
+    template <typename Policy>
+    class cycle_collector
+    {
+    public:
+        struct result
+        {
+            size_t objects;
+            size_t bytes;
+        };
+
+        cycle_collector() = default;
+        cycle_collector(const cycle_collector &) = delete;
+        cycle_collector &operator=(const cycle_collector &) = delete;
+
+        template <typename data_t>
+        void track(const shared_ptr<data_t, Policy> &ptr)
+        {
+            static_assert(std::is_base_of<traceable<Policy>, data_t>::value,
+                          "tracked objects must derive from traceable");
+            if (ptr.get() == nullptr)
+                return;
+
+            traceable<Policy> *object = ptr.get();
+            auto found = entries_.find(object);
+            // A dead entry at the same address belonged to an earlier object.
+            if (found != entries_.end() && !found->second.ref_.expired())
+                return;
+            entries_.insert_or_assign(object, entry{weak_ptr<traceable<Policy>, Policy>(ptr),
+                                                    sizeof(data_t)});
+        }
+
+        // Objects tracked and not yet known to be dead.
+        size_t tracked() const noexcept { return entries_.size(); }
+
+        result collect()
+        {
+            prune();
+
+            for (auto &item : entries_)
+            {
+                item.second.gc_refs_ = item.second.ref_.use_count();
+                item.second.reachable_ = false;
+            }
+
+            cycle_tracer<Policy> subtract(*this, cycle_tracer<Policy>::pass::subtract);
+            for (auto &item : entries_)
+                item.first->trace(subtract);
+
+            for (auto &item : entries_)
+            {
+                if (item.second.gc_refs_ > 0 && !item.second.reachable_)
+                {
+                    item.second.reachable_ = true;
+                    pending_.push_back(item.first);
+                }
+            }
+            cycle_tracer<Policy> mark(*this, cycle_tracer<Policy>::pass::mark);
+            while (!pending_.empty())
+            {
+                traceable<Policy> *object = pending_.back();
+                pending_.pop_back();
+                object->trace(mark);
+            }
+
+            // Hold the garbage while its edges are cut, then let it go.
+            std::vector<shared_ptr<traceable<Policy>, Policy>> garbage;
+            result freed{0, 0};
+            for (auto it = entries_.begin(); it != entries_.end();)
+            {
+                if (it->second.reachable_)
+                {
+                    ++it;
+                    continue;
+                }
+                garbage.push_back(it->second.ref_.lock());
+                ++freed.objects;
+                freed.bytes += it->second.bytes_;
+                it = entries_.erase(it);
+            }
+
+            cycle_tracer<Policy> clear(*this, cycle_tracer<Policy>::pass::clear);
+            for (auto &object : garbage)
+                object->trace(clear);
+            garbage.clear();
+
+            reclaimed_bytes_ += freed.bytes;
+            return freed;
+        }
+
+        // Bytes freed by all collect() calls so far, counting sizeof of
+        // each object.
+        size_t reclaimed_bytes() const noexcept { return reclaimed_bytes_; }
+
+    private:
+        struct entry
+        {
+            weak_ptr<traceable<Policy>, Policy> ref_;
+            size_t bytes_;
+            size_t gc_refs_{0};
+            bool reachable_{false};
+        };
+
+        // Forgets objects that died without help.
+        void prune()
+        {
+            for (auto it = entries_.begin(); it != entries_.end();)
+            {
+                if (it->second.ref_.expired())
+                    it = entries_.erase(it);
+                else
+                    ++it;
+            }
+        }
+
+        void visit_edge(traceable<Policy> *target, typename cycle_tracer<Policy>::pass current)
+        {
+            auto found = entries_.find(target);
+            if (found == entries_.end())
+                return;
+
+            entry &target_entry = found->second;
+            if (current == cycle_tracer<Policy>::pass::subtract)
+            {
+                --target_entry.gc_refs_;
+            }
+            else if (!target_entry.reachable_)
+            {
+                target_entry.reachable_ = true;
+                pending_.push_back(target);
+            }
+        }
+
+        std::unordered_map<traceable<Policy> *, entry> entries_;
+        std::vector<traceable<Policy> *> pending_;
+        size_t reclaimed_bytes_{0};
+
+        friend class cycle_tracer<Policy>;
+    };
+
+}
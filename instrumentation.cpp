@@ -0,0 +1,314 @@
+#pragma once
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#ifdef CUSTOM_CLASSES_INSTRUMENT
+#include <atomic>
+#include <mutex>
+#include <typeinfo>
+#if defined(__GNUG__)
+#include <cstdlib>
+#include <cxxabi.h>
+#endif
+#endif
+
+// Public functions that create an owner are marked CUSTOM_CLASSES_ENTRY and
+// pass CUSTOM_CLASSES_CALLER down as the allocation site. While
+// instrumenting they stay out of line, so the return address they read is
+// in the code that called them rather than somewhere inside the library.
+#if defined(CUSTOM_CLASSES_INSTRUMENT) && defined(__GNUC__)
+#define CUSTOM_CLASSES_ENTRY [[gnu::noinline]]
+#define CUSTOM_CLASSES_CALLER __builtin_return_address(0)
+#else
+#define CUSTOM_CLASSES_ENTRY
+#define CUSTOM_CLASSES_CALLER nullptr
+#endif
+
+// Ownership counters for unique_ptr and shared_ptr, per pointee type.
+// Define CUSTOM_CLASSES_INSTRUMENT (the same way in every translation unit)
+// to turn them on. Without it the hooks are empty inline functions and the
+// control block base is an empty class, so nothing is left in the build.
+namespace custom_classes
+{
+
+    namespace instrumentation
+    {
+        struct call_site
+        {
+            const void *address;
+            size_t samples;
+        };
+
+        // Snapshot of the counters of one type.
+        struct type_report
+        {
+            std::string name;
+            size_t allocations;
+            size_t frees;
+            size_t live;
+            size_t peak_live;
+            size_t ref_ops;
+            std::vector<call_site> sites;
+        };
+
+        // Live control blocks of every type and policy.
+        struct block_report
+        {
+            size_t live;
+            size_t peak_live;
+        };
+
+#ifdef CUSTOM_CLASSES_INSTRUMENT
+        constexpr bool enabled = true;
+
+        namespace detail
+        {
+            inline void raise_peak(std::atomic<size_t> &peak, size_t value) noexcept
+            {
+                size_t current = peak.load(std::memory_order_relaxed);
+                while (current < value &&
+                       !peak.compare_exchange_weak(current, value, std::memory_order_relaxed))
+                {
+                }
+            }
+
+            inline std::atomic<size_t> &sample_rate()
+            {
+                static std::atomic<size_t> rate{0};
+                return rate;
+            }
+
+            inline std::atomic<size_t> &live_blocks()
+            {
+                static std::atomic<size_t> live{0};
+                return live;
+            }
+
+            inline std::atomic<size_t> &peak_blocks()
+            {
+                static std::atomic<size_t> peak{0};
+                return peak;
+            }
+
+            inline std::string demangle(const char *name)
+            {
+#if defined(__GNUG__)
+                int status = 0;
+                char *readable = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+                if (status == 0 && readable != nullptr)
+                {
+                    std::string result(readable);
+                    std::free(readable);
+                    return result;
+                }
+#endif
+                return name;
+            }
+        }
+
+        // Counters of one type. Instances are created on first use and
+        // chained into a list that report() walks; they are never freed.
+        struct type_stats
+        {
+            static constexpr size_t kMaxSites = 16;
+
+            const std::type_info &type_;
+            std::atomic<size_t> allocations_{0};
+            std::atomic<size_t> frees_{0};
+            std::atomic<size_t> live_{0};
+            std::atomic<size_t> peak_live_{0};
+            std::atomic<size_t> ref_ops_{0};
+            std::mutex sites_mutex_;
+            call_site sites_[kMaxSites]{};
+            size_t site_count_{0};
+            type_stats *next_{nullptr};
+
+            explicit type_stats(const std::type_info &type) : type_(type)
+            {
+                next_ = head().load(std::memory_order_relaxed);
+                while (!head().compare_exchange_weak(next_, this, std::memory_order_release,
+                                                     std::memory_order_relaxed))
+                {
+                }
+            }
+
+            static std::atomic<type_stats *> &head()
+            {
+                static std::atomic<type_stats *> first{nullptr};
+                return first;
+            }
+
+            void record_site(const void *address)
+            {
+                std::lock_guard<std::mutex> lock(sites_mutex_);
+                for (size_t i = 0; i < site_count_; ++i)
+                {
+                    if (sites_[i].address == address)
+                    {
+                        ++sites_[i].samples;
+                        return;
+                    }
+                }
+                if (site_count_ < kMaxSites)
+                    sites_[site_count_++] = {address, 1};
+            }
+        };
+
+        template <typename data_t>
+        type_stats &stats_for()
+        {
+            static type_stats stats(typeid(data_t));
+            return stats;
+        }
+
+        // `site` is the CUSTOM_CLASSES_CALLER of the entry point, a return
+        // address; `addr2line -f -i` on site - 1 gives the calling line.
+        inline void on_allocate(type_stats &stats, const void *site) noexcept
+        {
+            size_t count = stats.allocations_.fetch_add(1, std::memory_order_relaxed) + 1;
+            size_t live = stats.live_.fetch_add(1, std::memory_order_relaxed) + 1;
+            detail::raise_peak(stats.peak_live_, live);
+
+            size_t rate = detail::sample_rate().load(std::memory_order_relaxed);
+            if (rate != 0 && count % rate == 0)
+                stats.record_site(site);
+        }
+
+        inline void on_free(type_stats &stats) noexcept
+        {
+            stats.frees_.fetch_add(1, std::memory_order_relaxed);
+            stats.live_.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        // Hooks used by unique_ptr, which has nowhere to keep the stats. An
+        // object counts as freed once it leaves unique_ptr ownership, so
+        // release() counts too.
+        template <typename data_t>
+        void track_adopt(const void *site) noexcept
+        {
+            on_allocate(stats_for<data_t>(), site);
+        }
+
+        template <typename data_t>
+        void track_free() noexcept { on_free(stats_for<data_t>()); }
+
+        // Base of every control block. The concrete block names its type
+        // once with track_allocate; frees and reference count traffic are
+        // then charged to that type.
+        class tracked_block
+        {
+        public:
+            template <typename data_t>
+            void track_allocate(const void *site) noexcept
+            {
+                stats_ = &stats_for<data_t>();
+                on_allocate(*stats_, site);
+            }
+
+            void track_free() noexcept
+            {
+                if (stats_ != nullptr)
+                    on_free(*stats_);
+            }
+
+            void track_ref() noexcept
+            {
+                if (stats_ != nullptr)
+                    stats_->ref_ops_.fetch_add(1, std::memory_order_relaxed);
+            }
+
+        protected:
+            tracked_block() noexcept
+            {
+                size_t live = detail::live_blocks().fetch_add(1, std::memory_order_relaxed) + 1;
+                detail::raise_peak(detail::peak_blocks(), live);
+            }
+            tracked_block(const tracked_block &) = delete;
+            tracked_block &operator=(const tracked_block &) = delete;
+            ~tracked_block() { detail::live_blocks().fetch_sub(1, std::memory_order_relaxed); }
+
+        private:
+            type_stats *stats_{nullptr};
+        };
+
+        // Records the creating call site of every `rate`-th allocation of
+        // each type. 0 turns sampling off, which is the default.
+        inline void set_sample_rate(size_t rate) noexcept
+        {
+            detail::sample_rate().store(rate, std::memory_order_relaxed);
+        }
+
+        inline std::vector<type_report> report()
+        {
+            std::vector<type_report> result;
+            for (type_stats *stats = type_stats::head().load(std::memory_order_acquire);
+                 stats != nullptr; stats = stats->next_)
+            {
+                type_report entry{detail::demangle(stats->type_.name()),
+                                  stats->allocations_.load(std::memory_order_relaxed),
+                                  stats->frees_.load(std::memory_order_relaxed),
+                                  stats->live_.load(std::memory_order_relaxed),
+                                  stats->peak_live_.load(std::memory_order_relaxed),
+                                  stats->ref_ops_.load(std::memory_order_relaxed),
+                                  {}};
+                std::lock_guard<std::mutex> lock(stats->sites_mutex_);
+                entry.sites.assign(stats->sites_, stats->sites_ + stats->site_count_);
+                result.push_back(std::move(entry));
+            }
+            return result;
+        }
+
+        inline block_report blocks() noexcept
+        {
+            return {detail::live_blocks().load(std::memory_order_relaxed),
+                    detail::peak_blocks().load(std::memory_order_relaxed)};
+        }
+#else
+        constexpr bool enabled = false;
+
+        template <typename data_t>
+        void track_adopt(const void *) noexcept {}
+
+        template <typename data_t>
+        void track_free() noexcept {}
+
+        class tracked_block
+        {
+        public:
+            template <typename data_t>
+            void track_allocate(const void *) noexcept {}
+            void track_free() noexcept {}
+            void track_ref() noexcept {}
+        };
+
+        inline void set_sample_rate(size_t) noexcept {}
+        inline std::vector<type_report> report() { return {}; }
+        inline block_report blocks() noexcept { return {0, 0}; }
+#endif
+
+        // One line per type, followed by its sampled call sites.
+        inline void dump(std::ostream &out)
+        {
+            if (!enabled)
+            {
+                out << "instrumentation disabled (define CUSTOM_CLASSES_INSTRUMENT)\n";
+                return;
+            }
+
+            block_report block_counts = blocks();
+            out << "control blocks: live " << block_counts.live << ", peak "
+                << block_counts.peak_live << '\n';
+            for (const type_report &entry : report())
+            {
+                out << entry.name << ": allocations " << entry.allocations << ", frees "
+                    << entry.frees << ", live " << entry.live << ", peak " << entry.peak_live
+                    << ", ref ops " << entry.ref_ops << '\n';
+                for (const call_site &site : entry.sites)
+                    out << "    " << site.address << " x" << site.samples << '\n';
+            }
+        }
+    }
+
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <cstddef>
+#include <utility>
+
+namespace custom_classes
+{
+
+    // Base for objects that carry their own reference count, so the pointer
+    // needs no separate control block. Not thread-safe.
+    class ref_counted
+    {
+    public:
+        size_t use_count() const noexcept { return ref_counter_; }
+
+    protected:
+        ref_counted() noexcept = default;
+        // A copy is a new object with its own owners.
+        ref_counted(const ref_counted &) noexcept {}
+        ref_counted &operator=(const ref_counted &) noexcept { return *this; }
+        virtual ~ref_counted() = default;
+
+    private:
+        mutable size_t ref_counter_{0};
+
+        friend void intrusive_ptr_add_ref(const ref_counted *ptr) noexcept
+        {
+            ++ptr->ref_counter_;
+        }
+
+        friend void intrusive_ptr_release(const ref_counted *ptr) noexcept
+        {
+            if (--ptr->ref_counter_ == 0)
+                delete ptr;
+        }
+    };
+
+    // Pointer to an object that counts its own references. Any type works as
+    // long as intrusive_ptr_add_ref/intrusive_ptr_release are found for it.
+    template <typename data_t>
+    struct intrusive_ptr
+    {
+    private:
+        data_t *ptr_;
+
+        template <typename T>
+        friend struct intrusive_ptr;
+
+    public:
+        intrusive_ptr(data_t *ptr = nullptr) noexcept : ptr_(ptr)
+        {
+            if (ptr_ != nullptr)
+                intrusive_ptr_add_ref(ptr_);
+        }
+
+        intrusive_ptr(const intrusive_ptr &other) noexcept : intrusive_ptr(other.ptr_) {}
+
+        template <typename T>
+        intrusive_ptr(const intrusive_ptr<T> &other) noexcept : intrusive_ptr(other.ptr_) {}
+
+        intrusive_ptr(intrusive_ptr &&other) noexcept : ptr_(other.ptr_)
+        {
+            other.ptr_ = nullptr;
+        }
+
+        template <typename T>
+        intrusive_ptr(intrusive_ptr<T> &&other) noexcept : ptr_(other.ptr_)
+        {
+            other.ptr_ = nullptr;
+        }
+
+        intrusive_ptr &operator=(const intrusive_ptr &other) noexcept
+        {
+            intrusive_ptr(other).swap(*this);
+            return *this;
+        }
+
+        intrusive_ptr &operator=(intrusive_ptr &&other) noexcept
+        {
+            intrusive_ptr(std::move(other)).swap(*this);
+            return *this;
+        }
+
+        ~intrusive_ptr()
+        {
+            if (ptr_ != nullptr)
+                intrusive_ptr_release(ptr_);
+        }
+
+        void swap(intrusive_ptr &other) noexcept { std::swap(ptr_, other.ptr_); }
+
+        data_t &operator*() const noexcept { return *ptr_; }
+        data_t *operator->() const noexcept { return ptr_; }
+        data_t *get() const noexcept { return ptr_; }
+        explicit operator bool() const noexcept { return ptr_ != nullptr; }
+    };
+
+    template <typename data_t, typename... Args>
+    intrusive_ptr<data_t> make_intrusive(Args &&...args)
+    {
+        return intrusive_ptr<data_t>(new data_t(std::forward<Args>(args)...));
+    }
+
+}
@@ -0,0 +1,295 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "uniqueptr.cpp"
+
+namespace custom_classes
+{
+
+    template <typename data_t>
+    class object_pool;
+
+    // Deleter of the handles an object_pool gives out: it destroys the object
+    // and puts its slot back on the pool's free list.
+    template <typename data_t>
+    struct pool_deleter
+    {
+        object_pool<data_t> *pool_{nullptr};
+
+        void operator()(data_t *ptr) noexcept
+        {
+            ptr->~data_t();
+            pool_->deallocate(ptr);
+        }
+    };
+
+    namespace detail
+    {
+        // Ids of the pools that are still alive. Thread caches keep the id of
+        // the pool they belong to and check it here before giving slots
+        // back, since the pool may be gone by then.
+        inline std::mutex &pool_registry_mutex()
+        {
+            static std::mutex mutex;
+            return mutex;
+        }
+
+        inline std::unordered_set<std::uint64_t> &pool_registry()
+        {
+            static std::unordered_set<std::uint64_t> ids;
+            return ids;
+        }
+
+        inline std::uint64_t next_pool_id() noexcept
+        {
+            static std::atomic<std::uint64_t> next{1};
+            return next.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Recycles the memory of objects of one type. Slots come from slabs of
+    // kSlabSlots and are never given back to the system before reset() or
+    // the pool's destruction. Each thread caches free slots for each of the
+    // last kCachedPools pools of this type it used, so acquiring and
+    // releasing usually take no lock, even when alternating between pools;
+    // a cache trades batches of kCacheBatch slots with the shared list.
+    //
+    // The pool must outlive its handles.
+    template <typename data_t>
+    class object_pool
+    {
+    public:
+        using handle = unique_ptr<data_t, pool_deleter<data_t>>;
+
+        static constexpr size_t kSlabSlots = 256;
+        static constexpr size_t kCacheBatch = 32;
+        static constexpr size_t kCachedPools = 8;
+
+        object_pool() : id_(detail::next_pool_id())
+        {
+            std::lock_guard<std::mutex> lock(detail::pool_registry_mutex());
+            detail::pool_registry().insert(id_);
+        }
+
+        object_pool(const object_pool &) = delete;
+        object_pool &operator=(const object_pool &) = delete;
+
+        ~object_pool()
+        {
+            assert(live() == 0 && "object_pool destroyed while handles are out");
+            std::lock_guard<std::mutex> lock(detail::pool_registry_mutex());
+            detail::pool_registry().erase(id_);
+        }
+
+        template <typename... Args>
+        handle acquire(Args &&...args)
+        {
+            slot *free_slot = allocate();
+            try
+            {
+                ::new (static_cast<void *>(free_slot->storage_)) data_t(std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                release_slot(free_slot);
+                throw;
+            }
+            live_.fetch_add(1, std::memory_order_relaxed);
+            return handle(std::launder(reinterpret_cast<data_t *>(free_slot->storage_)),
+                          pool_deleter<data_t>{this});
+        }
+
+        // Gives every slab back to the system at once, e.g. when a level is
+        // unloaded. No handles may be out and no other thread may be using
+        // the pool; slots cached by other threads are dropped the next time
+        // those threads touch it.
+        void reset()
+        {
+            assert(live() == 0 && "object_pool reset while handles are out");
+            std::lock_guard<std::mutex> lock(mutex_);
+            generation_.fetch_add(1, std::memory_order_release);
+            free_ = nullptr;
+            slabs_.clear();
+        }
+
+        size_t live() const noexcept { return live_.load(std::memory_order_relaxed); }
+
+        size_t capacity() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return slabs_.size() * kSlabSlots;
+        }
+
+    private:
+        union slot
+        {
+            slot *next_;
+            alignas(data_t) unsigned char storage_[sizeof(data_t)];
+        };
+
+        struct thread_cache
+        {
+            object_pool *owner_{nullptr};
+            std::uint64_t id_{0};
+            std::uint64_t generation_{0};
+            slot *free_{nullptr};
+            size_t count_{0};
+            std::uint64_t last_use_{0};
+
+            ~thread_cache() { flush(); }
+
+            // Hands the cached slots back to their pool if it is still
+            // there; give_back drops them if the pool was reset since.
+            void flush()
+            {
+                if (free_ != nullptr)
+                {
+                    std::lock_guard<std::mutex> lock(detail::pool_registry_mutex());
+                    if (detail::pool_registry().count(id_) != 0)
+                        owner_->give_back(free_, count_, generation_);
+                }
+                owner_ = nullptr;
+                id_ = 0;
+                free_ = nullptr;
+                count_ = 0;
+            }
+
+            void push(slot *free_slot) noexcept
+            {
+                free_slot->next_ = free_;
+                free_ = free_slot;
+                ++count_;
+            }
+
+            slot *pop() noexcept
+            {
+                slot *free_slot = free_;
+                free_ = free_slot->next_;
+                --count_;
+                return free_slot;
+            }
+
+            // Unlinks the first `n` cached slots and returns them as a list.
+            slot *split(size_t n) noexcept
+            {
+                slot *first = free_;
+                slot *last = free_;
+                for (size_t i = 1; i < n; ++i)
+                    last = last->next_;
+                free_ = last->next_;
+                last->next_ = nullptr;
+                count_ -= n;
+                return first;
+            }
+        };
+
+        // The calling thread's cache for this pool. A pool without one takes
+        // over the least recently used cache, whose slots go back first.
+        thread_cache &local_cache()
+        {
+            thread_local thread_cache caches[kCachedPools];
+            thread_local std::uint64_t clock = 0;
+
+            thread_cache *cache = &caches[0];
+            for (thread_cache &entry : caches)
+            {
+                if (entry.id_ == id_)
+                {
+                    cache = &entry;
+                    break;
+                }
+                if (entry.last_use_ < cache->last_use_)
+                    cache = &entry;
+            }
+
+            std::uint64_t generation = generation_.load(std::memory_order_acquire);
+            if (cache->id_ != id_ || cache->generation_ != generation)
+            {
+                cache->flush();
+                cache->owner_ = this;
+                cache->id_ = id_;
+                cache->generation_ = generation;
+            }
+            cache->last_use_ = ++clock;
+            return *cache;
+        }
+
+        slot *allocate()
+        {
+            thread_cache &cache = local_cache();
+            if (cache.free_ == nullptr)
+                refill(cache);
+            return cache.pop();
+        }
+
+        void release_slot(slot *free_slot)
+        {
+            thread_cache &cache = local_cache();
+            cache.push(free_slot);
+            if (cache.count_ >= 2 * kCacheBatch)
+                give_back(cache.split(kCacheBatch), kCacheBatch, cache.generation_);
+        }
+
+        void deallocate(data_t *ptr)
+        {
+            live_.fetch_sub(1, std::memory_order_relaxed);
+            release_slot(reinterpret_cast<slot *>(ptr));
+        }
+
+        void refill(thread_cache &cache)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (free_ == nullptr)
+            {
+                slabs_.emplace_back(new slot[kSlabSlots]);
+                slot *slab = slabs_.back().get();
+                for (size_t i = 0; i < kSlabSlots; ++i)
+                {
+                    slab[i].next_ = free_;
+                    free_ = &slab[i];
+                }
+            }
+            for (size_t i = 0; i < kCacheBatch && free_ != nullptr; ++i)
+            {
+                slot *free_slot = free_;
+                free_ = free_slot->next_;
+                cache.push(free_slot);
+            }
+        }
+
+        // Links `count` slots taken in `generation` back into the free
+        // list. Slots from before a reset() belong to slabs that are gone,
+        // so they are dropped; the check is made under mutex_, which reset()
+        // holds while it frees the slabs.
+        void give_back(slot *first, size_t count, std::uint64_t generation)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (generation_.load(std::memory_order_relaxed) != generation)
+                return;
+
+            slot *last = first;
+            for (size_t i = 1; i < count; ++i)
+                last = last->next_;
+            last->next_ = free_;
+            free_ = first;
+        }
+
+        const std::uint64_t id_;
+        std::atomic<std::uint64_t> generation_{0};
+        std::atomic<size_t> live_{0};
+        mutable std::mutex mutex_;
+        slot *free_{nullptr};
+        std::vector<unique_ptr<slot[]>> slabs_;
+
+        friend struct pool_deleter<data_t>;
+    };
+
+}
@@ -0,0 +1,181 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace custom_classes
+{
+
+    // Retire list for objects whose destruction should not happen where the
+    // last reference is dropped, e.g. a whole level released in the middle of
+    // a frame. retire() only queues the object, tagged with the current
+    // epoch. The game loop calls advance_epoch() once per frame. The queue is
+    // drained at an idle point (drain(), drain_for()) or by a background
+    // thread. An object is never destroyed in the epoch it was retired in,
+    // so raw pointers obtained during the current frame stay valid until the
+    // frame ends.
+    //
+    // A background thread runs the destructors on itself, off the thread
+    // that dropped the object. Whatever those destructors release must then
+    // be safe to release from another thread: shared_ptrs with the default
+    // nonatomic_policy, still shared with objects the game loop uses, race on
+    // their counts. Give such members atomic_policy or biased_policy, or
+    // drain from the game loop instead.
+    class deferred_reclaimer
+    {
+    public:
+        using destroy_fn = void (*)(void *) noexcept;
+
+        deferred_reclaimer() = default;
+        deferred_reclaimer(const deferred_reclaimer &) = delete;
+        deferred_reclaimer &operator=(const deferred_reclaimer &) = delete;
+
+        // Destructors of drained objects may retire their children, so this
+        // repeats until nothing is left.
+        ~deferred_reclaimer()
+        {
+            stop_background();
+            do
+            {
+                advance_epoch();
+                drain();
+            } while (pending() != 0);
+        }
+
+        static deferred_reclaimer &global()
+        {
+            static deferred_reclaimer reclaimer;
+            return reclaimer;
+        }
+
+        // Called from deleters, so it does not throw: if the queue cannot
+        // grow, the object is destroyed right away instead.
+        void retire(void *ptr, destroy_fn destroy) noexcept
+        {
+            try
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                retired_.push_back({ptr, destroy, epoch_});
+                return;
+            }
+            catch (...)
+            {
+            }
+            destroy(ptr);
+        }
+
+        void advance_epoch()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++epoch_;
+        }
+
+        // Destroys everything retired before the current epoch.
+        size_t drain() { return drain_until(std::chrono::steady_clock::time_point::max()); }
+
+        // Same, but stops once `budget` is used up; the rest stays queued.
+        size_t drain_for(std::chrono::microseconds budget)
+        {
+            return drain_until(std::chrono::steady_clock::now() + budget);
+        }
+
+        size_t pending() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return retired_.size();
+        }
+
+        // Drains every `period` on a separate thread until stopped. See the
+        // class comment for what the destructors may then touch.
+        void start_background(std::chrono::milliseconds period)
+        {
+            stop_background();
+            stop_ = false;
+            worker_ = std::thread([this, period]()
+                                  {
+                                      std::unique_lock<std::mutex> lock(mutex_);
+                                      while (!stop_)
+                                      {
+                                          wakeup_.wait_for(lock, period);
+                                          lock.unlock();
+                                          drain();
+                                          lock.lock();
+                                      }
+                                  });
+        }
+
+        void stop_background()
+        {
+            if (!worker_.joinable())
+                return;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            wakeup_.notify_one();
+            worker_.join();
+        }
+
+    private:
+        struct retired_object
+        {
+            void *ptr_;
+            destroy_fn destroy_;
+            size_t epoch_;
+        };
+
+        // Destroys in batches without holding the lock, since destructors may
+        // retire further objects.
+        size_t drain_until(std::chrono::steady_clock::time_point deadline)
+        {
+            const size_t kBatch = 64;
+            size_t destroyed = 0;
+            retired_object batch[kBatch];
+            for (;;)
+            {
+                size_t count = 0;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    while (count < kBatch && !retired_.empty() &&
+                           retired_.front().epoch_ < epoch_)
+                    {
+                        batch[count++] = retired_.front();
+                        retired_.pop_front();
+                    }
+                }
+                for (size_t i = 0; i < count; ++i)
+                    batch[i].destroy_(batch[i].ptr_);
+                destroyed += count;
+
+                if (count < kBatch || std::chrono::steady_clock::now() >= deadline)
+                    return destroyed;
+            }
+        }
+
+        mutable std::mutex mutex_;
+        std::condition_variable wakeup_;
+        std::deque<retired_object> retired_;
+        size_t epoch_{0};
+        bool stop_{false};
+        std::thread worker_;
+    };
+
+    // Deleter that hands the object to a deferred_reclaimer instead of
+    // deleting it, for use with shared_ptr(ptr, deleter) or unique_ptr.
+    template <typename data_t>
+    struct deferred_delete
+    {
+        deferred_reclaimer *reclaimer_ = &deferred_reclaimer::global();
+
+        void operator()(data_t *ptr) const noexcept
+        {
+            if (ptr == nullptr)
+                return;
+            reclaimer_->retire(ptr, [](void *object) noexcept
+                               { delete static_cast<data_t *>(object); });
+        }
+    };
+
+}
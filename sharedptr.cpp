@@ -1,106 +1,1107 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
 #include <utility>
 
+#include "instrumentation.cpp"
+
 namespace custom_classes
 {
 
-    template <typename data_t>
-    struct shared_ptr   
+    // Reference counting policies. The policy is a template parameter of
+    // shared_ptr, so the choice costs nothing at runtime.
+
+    // Plain counter: fastest, but the pointers must stay on one thread.
+    struct nonatomic_policy
+    {
+        class counter
+        {
+            size_t count_;
+
+        public:
+            explicit counter(size_t initial) noexcept : count_(initial) {}
+
+            void increment() noexcept { ++count_; }
+            bool decrement() noexcept { return --count_ == 0; }
+            bool increment_if_nonzero() noexcept
+            {
+                if (count_ == 0)
+                    return false;
+                ++count_;
+                return true;
+            }
+            size_t load() const noexcept { return count_; }
+        };
+
+        using weak_counter = counter;
+    };
+
+    // Every operation is atomic, so copies may be shared between threads.
+    struct atomic_policy
+    {
+        class counter
+        {
+            std::atomic<size_t> count_;
+
+        public:
+            explicit counter(size_t initial) noexcept : count_(initial) {}
+
+            void increment(size_t n = 1) noexcept { count_.fetch_add(n, std::memory_order_relaxed); }
+            bool decrement() noexcept
+            {
+                return count_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+            }
+            bool increment_if_nonzero() noexcept
+            {
+                size_t count = count_.load(std::memory_order_relaxed);
+                while (count != 0)
+                {
+                    if (count_.compare_exchange_weak(count, count + 1, std::memory_order_acq_rel,
+                                                     std::memory_order_relaxed))
+                        return true;
+                }
+                return false;
+            }
+            size_t load() const noexcept { return count_.load(std::memory_order_relaxed); }
+        };
+
+        using weak_counter = counter;
+    };
+
+    // Biased counting: the thread that created the object updates a plain
+    // counter, other threads update an atomic one. When the owner drops its
+    // last reference it merges into the atomic counter, and from then on
+    // everybody uses the atomic path. The atomic word keeps the count in the
+    // upper bits, a "queued" flag in bit 1 and the "merged" flag in bit 0.
+    //
+    // A reference counted by the owner may be dropped on another thread,
+    // which then takes the shared count below zero. Only the owner knows
+    // whether that was the last reference, so the counter is queued for it:
+    // the owner merges and, if nothing is left, frees the object the next
+    // time it drops a reference to that object, when it calls
+    // merge_pending(), or when the thread exits. Threads that hand objects
+    // off should call merge_pending() now and then (e.g. once per frame).
+    // Before the merge, weak_ptr::lock on another thread may still succeed
+    // for an object whose last reference is already gone.
+    struct biased_policy
+    {
+        using release_fn = void (*)(void *);
+
+        class counter;
+
+        // Merges and releases the counters other threads queued for the
+        // calling thread.
+        static void merge_pending() noexcept
+        {
+            local_queue().drain();
+        }
+
+    private:
+        // Counters queued for one owner thread, linked through the counters
+        // themselves so queuing never allocates.
+        struct merge_queue
+        {
+            counter *head_{nullptr};
+
+            merge_queue()
+            {
+                std::lock_guard<std::mutex> lock(registry_mutex());
+                registry()[std::this_thread::get_id()] = this;
+            }
+
+            ~merge_queue()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(registry_mutex());
+                    registry().erase(std::this_thread::get_id());
+                }
+                drain();
+            }
+
+            void drain() noexcept;
+        };
+
+        static std::mutex &registry_mutex()
+        {
+            static std::mutex mutex;
+            return mutex;
+        }
+
+        static std::unordered_map<std::thread::id, merge_queue *> &registry()
+        {
+            static std::unordered_map<std::thread::id, merge_queue *> queues;
+            return queues;
+        }
+
+        static merge_queue &local_queue()
+        {
+            thread_local merge_queue queue;
+            return queue;
+        }
+
+    public:
+        class counter
+        {
+            static constexpr std::ptrdiff_t kMerged = 1;
+            static constexpr std::ptrdiff_t kQueued = 2;
+            static constexpr std::ptrdiff_t kOne = 4;
+
+            std::thread::id owner_;
+            size_t biased_;     // owner thread only
+            bool merged_{false}; // owner thread only
+            std::atomic<std::ptrdiff_t> shared_{0};
+
+            // Set by the thread that queues the counter.
+            counter *next_{nullptr};
+            release_fn release_{nullptr};
+            void *block_{nullptr};
+
+            bool owned() const noexcept
+            {
+                return std::this_thread::get_id() == owner_ && !merged_;
+            }
+
+            // Queues the counter for its owner, or merges it right away if
+            // the owner thread is gone.
+            void hand_to_owner(release_fn release, void *block) noexcept
+            {
+                release_ = release;
+                block_ = block;
+                {
+                    std::lock_guard<std::mutex> lock(registry_mutex());
+                    auto found = registry().find(owner_);
+                    if (found != registry().end())
+                    {
+                        next_ = found->second->head_;
+                        found->second->head_ = this;
+                        return;
+                    }
+                }
+                merge();
+            }
+
+            // Moves the owner's count into the shared word and frees the
+            // object if no references are left. Runs on the owner thread,
+            // or anywhere once the owner has exited.
+            void merge() noexcept
+            {
+                if (!merged_)
+                {
+                    merged_ = true;
+                    shared_.fetch_add(static_cast<std::ptrdiff_t>(biased_) * kOne + kMerged,
+                                      std::memory_order_acq_rel);
+                }
+                std::ptrdiff_t word = shared_.fetch_and(~kQueued, std::memory_order_acq_rel);
+                if ((word >> 2) == 0)
+                    release_(block_);
+            }
+
+            friend struct biased_policy::merge_queue;
+
+        public:
+            explicit counter(size_t initial) noexcept : owner_(std::this_thread::get_id()),
+                                                        biased_(initial)
+            {
+                // Registers the owner so other threads can queue for it.
+                local_queue();
+            }
+
+            void increment() noexcept
+            {
+                if (owned())
+                    ++biased_;
+                else
+                    shared_.fetch_add(kOne, std::memory_order_relaxed);
+            }
+
+            // Returns true if the caller must free the object now. `release`
+            // is called with `block` instead if the last reference turns out
+            // to be gone only once the owner merges.
+            bool decrement(release_fn release, void *block) noexcept
+            {
+                if (owned())
+                {
+                    std::ptrdiff_t word = shared_.load(std::memory_order_acquire);
+                    if (--biased_ != 0)
+                    {
+                        // Other threads dropped references counted here; this
+                        // may have been the last one.
+                        if ((word & kQueued) != 0)
+                            merge_pending();
+                        return false;
+                    }
+                    merged_ = true;
+                    word = shared_.fetch_or(kMerged, std::memory_order_acq_rel);
+                    if ((word & kQueued) == 0)
+                        return (word >> 2) == 0;
+                    // A queued counter is released by the merge.
+                    merge_pending();
+                    return false;
+                }
+
+                std::ptrdiff_t word = shared_.load(std::memory_order_relaxed);
+                while (true)
+                {
+                    if ((word & kMerged) != 0)
+                    {
+                        word = shared_.fetch_sub(kOne, std::memory_order_acq_rel);
+                        return (word & kQueued) == 0 && (word >> 2) == 1;
+                    }
+                    // Going below zero and queuing happen in one step, so
+                    // the owner cannot free the object in between.
+                    std::ptrdiff_t next = word - kOne;
+                    bool queue = (next >> 2) < 0 && (word & kQueued) == 0;
+                    if (queue)
+                        next |= kQueued;
+                    if (shared_.compare_exchange_weak(word, next, std::memory_order_acq_rel,
+                                                      std::memory_order_relaxed))
+                    {
+                        if (queue)
+                            hand_to_owner(release, block);
+                        return false;
+                    }
+                }
+            }
+
+            bool increment_if_nonzero() noexcept
+            {
+                if (owned())
+                {
+                    // Nothing can free the object behind the owner's back
+                    // before it merges.
+                    std::ptrdiff_t shared = shared_.load(std::memory_order_acquire) >> 2;
+                    if (static_cast<std::ptrdiff_t>(biased_) + shared <= 0)
+                        return false;
+                    ++biased_;
+                    return true;
+                }
+                std::ptrdiff_t word = shared_.load(std::memory_order_relaxed);
+                while ((word & kMerged) == 0 || (word >> 2) != 0)
+                {
+                    if (shared_.compare_exchange_weak(word, word + kOne, std::memory_order_acq_rel,
+                                                      std::memory_order_relaxed))
+                        return true;
+                }
+                return false;
+            }
+
+            // Exact on the owner thread, approximate on the others.
+            size_t load() const noexcept
+            {
+                std::ptrdiff_t shared = shared_.load(std::memory_order_relaxed) >> 2;
+                std::ptrdiff_t total = (owned() ? static_cast<std::ptrdiff_t>(biased_) : 0) + shared;
+                return total > 0 ? static_cast<size_t>(total) : 0;
+            }
+        };
+
+        // Weak references are rare enough to always use the atomic path.
+        using weak_counter = atomic_policy::counter;
+    };
+
+    inline void biased_policy::merge_queue::drain() noexcept
+    {
+        while (true)
+        {
+            counter *pending;
+            {
+                std::lock_guard<std::mutex> lock(registry_mutex());
+                pending = head_;
+                head_ = nullptr;
+            }
+            if (pending == nullptr)
+                return;
+            while (pending != nullptr)
+            {
+                counter *next = pending->next_;
+                pending->merge();
+                pending = next;
+            }
+        }
+    }
+
+    namespace detail
+    {
+        // Counters whose last release may be found late, by another thread,
+        // take a callback that frees the object then.
+        template <typename Counter, typename = void>
+        struct defers_release : std::false_type
+        {
+        };
+
+        template <typename Counter>
+        struct defers_release<Counter, std::void_t<decltype(std::declval<Counter &>().decrement(
+                                           std::declval<void (*)(void *)>(),
+                                           std::declval<void *>()))>> : std::true_type
+        {
+        };
+
+        // Counters shared by all owners of one object. The object lives while
+        // there are strong references; the block lives while there are weak
+        // references, and all strong references together hold one weak one.
+        // The concrete block decides how the object and the block itself are
+        // released.
+        template <typename Policy>
+        struct control_block : instrumentation::tracked_block
+        {
+            typename Policy::counter ref_counter_{1};
+            typename Policy::weak_counter weak_counter_{1};
+
+            virtual void destroy_object() noexcept = 0;
+            virtual void destroy_block() noexcept = 0;
+
+            void add_ref() noexcept
+            {
+                this->track_ref();
+                ref_counter_.increment();
+            }
+
+            void add_ref(size_t n) noexcept
+            {
+                this->track_ref();
+                ref_counter_.increment(n);
+            }
+
+            bool try_add_ref() noexcept
+            {
+                this->track_ref();
+                return ref_counter_.increment_if_nonzero();
+            }
+
+            void add_weak_ref() noexcept
+            {
+                this->track_ref();
+                weak_counter_.increment();
+            }
+
+            void release() noexcept
+            {
+                this->track_ref();
+                bool last;
+                if constexpr (defers_release<typename Policy::counter>::value)
+                    last = ref_counter_.decrement(&control_block::release_object, this);
+                else
+                    last = ref_counter_.decrement();
+                if (last)
+                    free_object();
+            }
+
+            void release_weak() noexcept
+            {
+                this->track_ref();
+                if (weak_counter_.decrement())
+                    destroy_block();
+            }
+
+        protected:
+            ~control_block() = default;
+
+        private:
+            void free_object() noexcept
+            {
+                this->track_free();
+                destroy_object();
+                release_weak();
+            }
+
+            static void release_object(void *block) noexcept
+            {
+                static_cast<control_block *>(block)->free_object();
+            }
+        };
+
+        struct object_delete
+        {
+            template <typename data_t>
+            void operator()(data_t *ptr) const noexcept { delete ptr; }
+        };
+
+        struct array_delete
+        {
+            template <typename data_t>
+            void operator()(data_t *ptr) const noexcept { delete[] ptr; }
+        };
+
+        // Block for an object allocated separately by the caller.
+        template <typename data_t, typename Deleter, typename Policy>
+        struct pointer_block final : control_block<Policy>
+        {
+            data_t *ptr_;
+            Deleter del_;
+
+            pointer_block(const void *site, data_t *ptr, Deleter del = Deleter()) noexcept
+                : ptr_(ptr), del_(std::move(del))
+            {
+                this->template track_allocate<data_t>(site);
+            }
+
+            void destroy_object() noexcept override { del_(ptr_); }
+            void destroy_block() noexcept override { delete this; }
+        };
+
+        // Block that stores the object itself, so make_shared needs a single
+        // allocation for both.
+        template <typename data_t, typename Policy>
+        struct inplace_block final : control_block<Policy>
+        {
+            alignas(data_t) unsigned char storage_[sizeof(data_t)];
+
+            template <typename... Args>
+            inplace_block(const void *site, Args &&...args)
+            {
+                ::new (static_cast<void *>(storage_)) data_t(std::forward<Args>(args)...);
+                this->template track_allocate<data_t>(site);
+            }
+
+            data_t *get() noexcept
+            {
+                return std::launder(reinterpret_cast<data_t *>(storage_));
+            }
+
+            void destroy_object() noexcept override { get()->~data_t(); }
+            void destroy_block() noexcept override { delete this; }
+        };
+
+        // Block followed by `size_` value-initialized elements in the same
+        // allocation. The elements start at a multiple of `alignment_`.
+        template <typename data_t, typename Policy>
+        struct array_block final : control_block<Policy>
+        {
+            data_t *data_{nullptr};
+            size_t size_{0};
+            size_t alignment_;
+
+            static size_t header_size(size_t alignment) noexcept
+            {
+                return (sizeof(array_block) + alignment - 1) / alignment * alignment;
+            }
+
+            static array_block *create(size_t size, size_t alignment, const void *site)
+            {
+                alignment = std::max({alignment, alignof(data_t), alignof(array_block)});
+                assert((alignment & (alignment - 1)) == 0 && "alignment must be a power of two");
+
+                size_t header = header_size(alignment);
+                void *memory = ::operator new(header + size * sizeof(data_t),
+                                              std::align_val_t(alignment));
+                auto *block = ::new (memory) array_block(alignment);
+                auto *data = reinterpret_cast<data_t *>(static_cast<char *>(memory) + header);
+                try
+                {
+                    std::uninitialized_value_construct_n(data, size);
+                }
+                catch (...)
+                {
+                    block->free_memory();
+                    throw;
+                }
+                block->data_ = data;
+                block->size_ = size;
+                block->template track_allocate<data_t>(site);
+                return block;
+            }
+
+            void destroy_object() noexcept override { std::destroy_n(data_, size_); }
+            void destroy_block() noexcept override { free_memory(); }
+
+        private:
+            explicit array_block(size_t alignment) noexcept : alignment_(alignment) {}
+
+            void free_memory() noexcept
+            {
+                size_t alignment = alignment_;
+                this->~array_block();
+                ::operator delete(static_cast<void *>(this), std::align_val_t(alignment));
+            }
+        };
+
+        // Same as inplace_block, but the memory comes from a caller-supplied
+        // allocator, which is kept in the block to give the memory back.
+        template <typename data_t, typename Alloc, typename Policy>
+        struct alloc_inplace_block final : control_block<Policy>
+        {
+            using allocator_type = typename std::allocator_traits<Alloc>::template rebind_alloc<
+                alloc_inplace_block>;
+            using traits = std::allocator_traits<allocator_type>;
+
+            allocator_type alloc_;
+            alignas(data_t) unsigned char storage_[sizeof(data_t)];
+
+            template <typename... Args>
+            alloc_inplace_block(const void *site, const allocator_type &alloc, Args &&...args)
+                : alloc_(alloc)
+            {
+                ::new (static_cast<void *>(storage_)) data_t(std::forward<Args>(args)...);
+                this->template track_allocate<data_t>(site);
+            }
+
+            data_t *get() noexcept
+            {
+                return std::launder(reinterpret_cast<data_t *>(storage_));
+            }
+
+            void destroy_object() noexcept override { get()->~data_t(); }
+            void destroy_block() noexcept override
+            {
+                allocator_type alloc(std::move(alloc_));
+                this->~alloc_inplace_block();
+                traits::deallocate(alloc, this, 1);
+            }
+        };
+    }
+
+    template <typename data_t, typename Policy = nonatomic_policy>
+    struct weak_ptr;
+
+    template <typename data_t, typename Policy = nonatomic_policy>
+    class enable_shared_from_this;
+
+    template <typename data_t, typename Policy = nonatomic_policy>
+    struct shared_ptr
     {
     private:
         data_t *ptr_;
-        size_t *ref_counter_;
+        detail::control_block<Policy> *ctrl_;
+
+        template <typename T>
+        using if_convertible = std::enable_if_t<std::is_convertible<T *, data_t *>::value>;
+
+        shared_ptr(data_t *ptr, detail::control_block<Policy> *ctrl) noexcept : ptr_(ptr),
+                                                                        ctrl_(ctrl) {}
+
+        void release() noexcept
+        {
+            if (ctrl_ != nullptr)
+                ctrl_->release();
+        }
+
+        // Called once a new object gets its first owner.
+        void enable_weak_this() noexcept { set_weak_this(ptr_); }
+
+        template <typename T>
+        void set_weak_this(const enable_shared_from_this<T, Policy> *base) noexcept
+        {
+            if (base != nullptr && base->weak_this_.expired())
+                base->weak_this_ = shared_ptr<T, Policy>(*this, static_cast<T *>(ptr_));
+        }
+
+        void set_weak_this(...) noexcept {}
+
+        template <typename T, typename P, typename... Args>
+        friend shared_ptr<T, P> make_shared(Args &&...args);
+        template <typename T, typename P, typename Alloc, typename... Args>
+        friend shared_ptr<T, P> allocate_shared(const Alloc &alloc, Args &&...args);
+        template <typename T, typename P>
+        friend struct shared_ptr;
+        template <typename T, typename P>
+        friend struct weak_ptr;
 
     public:
-        shared_ptr(data_t *ptr = nullptr) : ptr_(ptr)
+        CUSTOM_CLASSES_ENTRY shared_ptr(data_t *ptr = nullptr) : ptr_(ptr), ctrl_(nullptr)
         {
             if (ptr == nullptr)
                 return;
             try
             {
-                ref_counter_ = new size_t{1};
+                ctrl_ = new detail::pointer_block<data_t, detail::object_delete, Policy>(
+                    CUSTOM_CLASSES_CALLER, ptr);
             }
             catch (...)
             {
                 delete ptr;
                 throw;
             }
+            enable_weak_this();
+        }
+
+        // `del(ptr)` runs instead of delete when the last owner goes.
+        template <typename Deleter,
+                  typename = std::enable_if_t<std::is_invocable<Deleter &, data_t *>::value>>
+        CUSTOM_CLASSES_ENTRY shared_ptr(data_t *ptr, Deleter del) : ptr_(ptr), ctrl_(nullptr)
+        {
+            if (ptr == nullptr)
+                return;
+            try
+            {
+                ctrl_ = new detail::pointer_block<data_t, Deleter, Policy>(CUSTOM_CLASSES_CALLER,
+                                                                          ptr, del);
+            }
+            catch (...)
+            {
+                del(ptr);
+                throw;
+            }
+            enable_weak_this();
+        }
+
+        shared_ptr(const shared_ptr &other) noexcept : ptr_(other.ptr_),
+                                                       ctrl_(other.ctrl_)
+        {
+            if (ctrl_ != nullptr)
+                ctrl_->add_ref();
+        }
+
+        shared_ptr(shared_ptr &&other) noexcept : ptr_(other.ptr_), ctrl_(other.ctrl_)
+        {
+            other.ptr_ = nullptr;
+            other.ctrl_ = nullptr;
+        }
+
+        // shared_ptr<Base> from shared_ptr<Derived>.
+        template <typename T, typename = if_convertible<T>>
+        shared_ptr(const shared_ptr<T, Policy> &other) noexcept : ptr_(other.ptr_),
+                                                                  ctrl_(other.ctrl_)
+        {
+            if (ctrl_ != nullptr)
+                ctrl_->add_ref();
+        }
+
+        template <typename T, typename = if_convertible<T>>
+        shared_ptr(shared_ptr<T, Policy> &&other) noexcept : ptr_(other.ptr_), ctrl_(other.ctrl_)
+        {
+            other.ptr_ = nullptr;
+            other.ctrl_ = nullptr;
+        }
+
+        // Aliasing: shares ownership with `owner` but points at `ptr`, e.g. a
+        // member of the owned object or a view into its buffer.
+        template <typename T>
+        shared_ptr(const shared_ptr<T, Policy> &owner, data_t *ptr) noexcept : ptr_(ptr),
+                                                                              ctrl_(owner.ctrl_)
+        {
+            if (ctrl_ != nullptr)
+                ctrl_->add_ref();
+        }
+
+        template <typename T>
+        shared_ptr(shared_ptr<T, Policy> &&owner, data_t *ptr) noexcept : ptr_(ptr),
+                                                                         ctrl_(owner.ctrl_)
+        {
+            owner.ptr_ = nullptr;
+            owner.ctrl_ = nullptr;
         }
- 
-        shared_ptr(const shared_ptr &other) : ptr_(other.ptr_),
-                                              ref_counter_(other.ref_counter_) { ++(*ref_counter_); }
- 
+
         shared_ptr &operator=(const shared_ptr &other) noexcept
         {
-            ~shared_ptr();
-            ptr_ = other.ptr_;
-            ref_counter_ = other.ref_counter_;
-            ++(*ref_counter_);
+            shared_ptr(other).swap(*this);
             return *this;
         }
- 
-        ~shared_ptr()
+
+        shared_ptr &operator=(shared_ptr &&other) noexcept
         {
-            if (--(*ref_counter_) == 0)
-            {
-                delete ref_counter_;
-                delete ptr_;
-            }
+            shared_ptr(std::move(other)).swap(*this);
+            return *this;
+        }
+
+        template <typename T, typename = if_convertible<T>>
+        shared_ptr &operator=(const shared_ptr<T, Policy> &other) noexcept
+        {
+            shared_ptr(other).swap(*this);
+            return *this;
+        }
+
+        template <typename T, typename = if_convertible<T>>
+        shared_ptr &operator=(shared_ptr<T, Policy> &&other) noexcept
+        {
+            shared_ptr(std::move(other)).swap(*this);
+            return *this;
         }
- 
+
+        ~shared_ptr() { release(); }
+
+        void swap(shared_ptr &other) noexcept
+        {
+            std::swap(ptr_, other.ptr_);
+            std::swap(ctrl_, other.ctrl_);
+        }
+
         data_t &operator*() const noexcept { return *ptr_; }
         data_t *operator->() const noexcept { return ptr_; }
-        size_t use_count() const noexcept { return *ref_counter_; }
+        data_t *get() const noexcept { return ptr_; }
+        size_t use_count() const noexcept { return ctrl_ ? ctrl_->ref_counter_.load() : 0; }
     };
 
-    template <typename data_t>
-    struct shared_ptr<data_t *>   
+    template <typename data_t, typename Policy = nonatomic_policy>
+    struct shared_slice;
+
+    // Owns an array. The size is known when the array comes from
+    // make_shared_array or the (ptr, size) constructor, and is 0 otherwise.
+    template <typename data_t, typename Policy>
+    struct shared_ptr<data_t *, Policy>
     {
     private:
         data_t *ptr_;
-        size_t *ref_counter_;
+        detail::control_block<Policy> *ctrl_;
+        size_t size_{0};
+
+        shared_ptr(data_t *ptr, size_t size, detail::control_block<Policy> *ctrl) noexcept
+            : ptr_(ptr), ctrl_(ctrl), size_(size) {}
+
+        void release() noexcept
+        {
+            if (ctrl_ != nullptr)
+                ctrl_->release();
+        }
+
+        // Gives ptr_ a control block; deletes the array if that fails.
+        void adopt(const void *site)
+        {
+            if (ptr_ == nullptr)
+                return;
+            try
+            {
+                ctrl_ = new detail::pointer_block<data_t, detail::array_delete, Policy>(site, ptr_);
+            }
+            catch (...)
+            {
+                delete[] ptr_;
+                throw;
+            }
+        }
+
+        template <typename T, typename P>
+        friend shared_ptr<T *, P> make_shared_array(size_t size, size_t alignment);
+        template <typename T, typename P>
+        friend struct shared_slice;
 
     public:
-        shared_ptr(data_t *ptr = nullptr) : ptr_(ptr)
+        CUSTOM_CLASSES_ENTRY shared_ptr(data_t *ptr = nullptr) : ptr_(ptr), ctrl_(nullptr)
+        {
+            adopt(CUSTOM_CLASSES_CALLER);
+        }
+
+        CUSTOM_CLASSES_ENTRY shared_ptr(data_t *ptr, size_t size) : ptr_(ptr), ctrl_(nullptr)
+        {
+            adopt(CUSTOM_CLASSES_CALLER);
+            size_ = ptr ? size : 0;
+        }
+
+        // `del(ptr)` runs instead of delete when the last owner goes.
+        template <typename Deleter,
+                  typename = std::enable_if_t<std::is_invocable<Deleter &, data_t *>::value>>
+        CUSTOM_CLASSES_ENTRY shared_ptr(data_t *ptr, Deleter del) : ptr_(ptr), ctrl_(nullptr)
         {
             if (ptr == nullptr)
                 return;
             try
             {
-                ref_counter_ = new size_t{1};
+                ctrl_ = new detail::pointer_block<data_t, Deleter, Policy>(CUSTOM_CLASSES_CALLER,
+                                                                          ptr, del);
             }
             catch (...)
             {
-                delete[] ptr;
+                del(ptr);
                 throw;
             }
         }
- 
-        shared_ptr(const shared_ptr &other) : ptr_(other.ptr_),
-                                              ref_counter_(other.ref_counter_) { ++(*ref_counter_); }
- 
-        shared_ptr &operator=(const shared_ptr &other)
+
+        shared_ptr(const shared_ptr &other) noexcept : ptr_(other.ptr_),
+                                                       ctrl_(other.ctrl_),
+                                                       size_(other.size_)
+        {
+            if (ctrl_ != nullptr)
+                ctrl_->add_ref();
+        }
+
+        shared_ptr(shared_ptr &&other) noexcept : ptr_(other.ptr_), ctrl_(other.ctrl_),
+                                                  size_(other.size_)
         {
-            ~shared_ptr();
-            ptr_ = other.ptr_;
-            ref_counter_ = other.ref_counter_;
-            ++(*ref_counter_);
+            other.ptr_ = nullptr;
+            other.ctrl_ = nullptr;
+            other.size_ = 0;
+        }
+
+        shared_ptr &operator=(const shared_ptr &other) noexcept
+        {
+            shared_ptr(other).swap(*this);
             return *this;
         }
- 
-        ~shared_ptr()
+
+        shared_ptr &operator=(shared_ptr &&other) noexcept
         {
-            if (--(*ref_counter_) == 0)
-            {
-                delete ref_counter_;
-                delete[] ptr_;
-            }
+            shared_ptr(std::move(other)).swap(*this);
+            return *this;
         }
- 
+
+        ~shared_ptr() { release(); }
+
+        void swap(shared_ptr &other) noexcept
+        {
+            std::swap(ptr_, other.ptr_);
+            std::swap(ctrl_, other.ctrl_);
+            std::swap(size_, other.size_);
+        }
+
         data_t &operator*() { return *ptr_; }
         data_t *operator->() { return ptr_; }
-        data_t &operator[](const size_t offset) { return *(ptr_ + offset); }
-        size_t use_count() const noexcept { return *ref_counter_; }
+        data_t &operator[](const size_t offset)
+        {
+            assert((size_ == 0 || offset < size_) && "shared_ptr<T*> index out of range");
+            return *(ptr_ + offset);
+        }
+        data_t *get() const noexcept { return ptr_; }
+        size_t size() const noexcept { return size_; }
+        size_t use_count() const noexcept { return ctrl_ ? ctrl_->ref_counter_.load() : 0; }
+
+        // `count` elements from `offset`, sharing ownership of the whole array.
+        shared_slice<data_t, Policy> slice(size_t offset, size_t count) const noexcept
+        {
+            return shared_slice<data_t, Policy>(*this).subslice(offset, count);
+        }
+    };
+
+    // View of a contiguous part of a shared array that keeps the whole array
+    // alive. Copying or slicing never copies elements. Index checks are
+    // asserts, so they vanish in builds with NDEBUG.
+    template <typename data_t, typename Policy>
+    struct shared_slice
+    {
+    private:
+        data_t *ptr_;
+        size_t size_;
+        detail::control_block<Policy> *ctrl_;
+
+    public:
+        shared_slice() noexcept : ptr_(nullptr), size_(0), ctrl_(nullptr) {}
+
+        shared_slice(const shared_ptr<data_t *, Policy> &array) noexcept : ptr_(array.ptr_),
+                                                                          size_(array.size_),
+                                                                          ctrl_(array.ctrl_)
+        {
+            if (ctrl_ != nullptr)
+                ctrl_->add_ref();
+        }
+
+        shared_slice(const shared_slice &other) noexcept : ptr_(other.ptr_), size_(other.size_),
+                                                           ctrl_(other.ctrl_)
+        {
+            if (ctrl_ != nullptr)
+                ctrl_->add_ref();
+        }
+
+        shared_slice(shared_slice &&other) noexcept : ptr_(other.ptr_), size_(other.size_),
+                                                      ctrl_(other.ctrl_)
+        {
+            other.ptr_ = nullptr;
+            other.size_ = 0;
+            other.ctrl_ = nullptr;
+        }
+
+        shared_slice &operator=(const shared_slice &other) noexcept
+        {
+            shared_slice(other).swap(*this);
+            return *this;
+        }
+
+        shared_slice &operator=(shared_slice &&other) noexcept
+        {
+            shared_slice(std::move(other)).swap(*this);
+            return *this;
+        }
+
+        ~shared_slice()
+        {
+            if (ctrl_ != nullptr)
+                ctrl_->release();
+        }
+
+        void swap(shared_slice &other) noexcept
+        {
+            std::swap(ptr_, other.ptr_);
+            std::swap(size_, other.size_);
+            std::swap(ctrl_, other.ctrl_);
+        }
+
+        shared_slice subslice(size_t offset, size_t count) const & noexcept
+        {
+            return shared_slice(*this).subslice(offset, count);
+        }
+
+        shared_slice subslice(size_t offset, size_t count) && noexcept
+        {
+            assert(offset <= size_ && count <= size_ - offset && "shared_slice out of range");
+            shared_slice result(std::move(*this));
+            result.ptr_ += offset;
+            result.size_ = count;
+            return result;
+        }
+
+        data_t &operator[](const size_t offset) const
+        {
+            assert(offset < size_ && "shared_slice index out of range");
+            return ptr_[offset];
+        }
+
+        data_t *data() const noexcept { return ptr_; }
+        size_t size() const noexcept { return size_; }
+        bool empty() const noexcept { return size_ == 0; }
+        data_t *begin() const noexcept { return ptr_; }
+        data_t *end() const noexcept { return ptr_ + size_; }
+        size_t use_count() const noexcept { return ctrl_ ? ctrl_->ref_counter_.load() : 0; }
+    };
+
+    // Non-owning reference. It keeps the control block alive but not the
+    // object, so with make_shared the object is destroyed when the last
+    // shared_ptr goes even though its storage is freed with the last weak_ptr.
+    template <typename data_t, typename Policy>
+    struct weak_ptr
+    {
+    private:
+        data_t *ptr_;
+        detail::control_block<Policy> *ctrl_;
+
+    public:
+        weak_ptr() noexcept : ptr_(nullptr), ctrl_(nullptr) {}
+
+        template <typename T,
+                  typename = std::enable_if_t<std::is_convertible<T *, data_t *>::value>>
+        weak_ptr(const shared_ptr<T, Policy> &other) noexcept : ptr_(other.ptr_),
+                                                                ctrl_(other.ctrl_)
+        {
+            if (ctrl_ != nullptr)
+                ctrl_->add_weak_ref();
+        }
+
+        weak_ptr(const weak_ptr &other) noexcept : ptr_(other.ptr_), ctrl_(other.ctrl_)
+        {
+            if (ctrl_ != nullptr)
+                ctrl_->add_weak_ref();
+        }
+
+        weak_ptr(weak_ptr &&other) noexcept : ptr_(other.ptr_), ctrl_(other.ctrl_)
+        {
+            other.ptr_ = nullptr;
+            other.ctrl_ = nullptr;
+        }
+
+        weak_ptr &operator=(const weak_ptr &other) noexcept
+        {
+            weak_ptr(other).swap(*this);
+            return *this;
+        }
+
+        weak_ptr &operator=(weak_ptr &&other) noexcept
+        {
+            weak_ptr(std::move(other)).swap(*this);
+            return *this;
+        }
+
+        template <typename T,
+                  typename = std::enable_if_t<std::is_convertible<T *, data_t *>::value>>
+        weak_ptr &operator=(const shared_ptr<T, Policy> &other) noexcept
+        {
+            weak_ptr(other).swap(*this);
+            return *this;
+        }
+
+        ~weak_ptr()
+        {
+            if (ctrl_ != nullptr)
+                ctrl_->release_weak();
+        }
+
+        void swap(weak_ptr &other) noexcept
+        {
+            std::swap(ptr_, other.ptr_);
+            std::swap(ctrl_, other.ctrl_);
+        }
+
+        void reset() noexcept { weak_ptr().swap(*this); }
+
+        size_t use_count() const noexcept { return ctrl_ ? ctrl_->ref_counter_.load() : 0; }
+        bool expired() const noexcept { return use_count() == 0; }
+
+        // Empty pointer if the object is already gone.
+        shared_ptr<data_t, Policy> lock() const noexcept
+        {
+            if (ctrl_ != nullptr && ctrl_->try_add_ref())
+                return shared_ptr<data_t, Policy>(ptr_, ctrl_);
+            return shared_ptr<data_t, Policy>();
+        }
+    };
+
+    // Base for objects that need a shared_ptr to themselves from inside a
+    // member function. The first shared_ptr that takes ownership of the
+    // object fills in weak_this_; shared_from_this() is empty before that.
+    template <typename data_t, typename Policy>
+    class enable_shared_from_this
+    {
+    public:
+        shared_ptr<data_t, Policy> shared_from_this() { return weak_this_.lock(); }
+        shared_ptr<const data_t, Policy> shared_from_this() const { return weak_this_.lock(); }
+        weak_ptr<data_t, Policy> weak_from_this() const noexcept { return weak_this_; }
+
+    protected:
+        enable_shared_from_this() noexcept = default;
+        enable_shared_from_this(const enable_shared_from_this &) noexcept {}
+        enable_shared_from_this &operator=(const enable_shared_from_this &) noexcept
+        {
+            return *this;
+        }
+        ~enable_shared_from_this() = default;
+
+    private:
+        mutable weak_ptr<data_t, Policy> weak_this_;
+
+        template <typename T, typename P>
+        friend struct shared_ptr;
     };
 
+    // Places the object and its control block in one allocation.
+    template <typename data_t, typename Policy = nonatomic_policy, typename... Args>
+    CUSTOM_CLASSES_ENTRY shared_ptr<data_t, Policy> make_shared(Args &&...args)
+    {
+        auto *block = new detail::inplace_block<data_t, Policy>(CUSTOM_CLASSES_CALLER,
+                                                                std::forward<Args>(args)...);
+        shared_ptr<data_t, Policy> result(block->get(), block);
+        result.enable_weak_this();
+        return result;
+    }
+
+    // make_shared with the object and its control block placed in memory from
+    // `alloc`, e.g. an arena_allocator or a pool_allocator.
+    template <typename data_t, typename Policy = nonatomic_policy, typename Alloc,
+              typename... Args>
+    CUSTOM_CLASSES_ENTRY shared_ptr<data_t, Policy> allocate_shared(const Alloc &alloc,
+                                                                    Args &&...args)
+    {
+        using block_t = detail::alloc_inplace_block<data_t, Alloc, Policy>;
+        typename block_t::allocator_type block_alloc(alloc);
+
+        block_t *block = block_t::traits::allocate(block_alloc, 1);
+        try
+        {
+            ::new (static_cast<void *>(block))
+                block_t(CUSTOM_CLASSES_CALLER, block_alloc, std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            block_t::traits::deallocate(block_alloc, block, 1);
+            throw;
+        }
+        shared_ptr<data_t, Policy> result(block->get(), block);
+        result.enable_weak_this();
+        return result;
+    }
+
+    // Array of `size` value-initialized elements sharing one allocation with
+    // its control block. The first element is aligned to `alignment`, e.g. 64
+    // for SIMD loads or to keep buffers on their own cache lines.
+    template <typename data_t, typename Policy = nonatomic_policy>
+    CUSTOM_CLASSES_ENTRY shared_ptr<data_t *, Policy> make_shared_array(
+        size_t size, size_t alignment = alignof(data_t))
+    {
+        auto *block =
+            detail::array_block<data_t, Policy>::create(size, alignment, CUSTOM_CLASSES_CALLER);
+        return shared_ptr<data_t *, Policy>(block->data_, size, block);
+    }
+
 }
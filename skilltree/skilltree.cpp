@@ -1,6 +1,7 @@
+#include "../intrusiveptr.cpp"
 #include "sfline.hpp"
 
-class Node
+class Node : public custom_classes::ref_counted
 {
 public:
   enum class State
@@ -20,7 +21,7 @@ public:
   sf::Vector2f getPosition();
 
   void onMousePressed(sf::Vector2f mouseCoords, MouseState state);
-  void addChild(const std::shared_ptr<Node> &child);
+  void addChild(const custom_classes::intrusive_ptr<Node> &child);
 
   void block();
   void unblock();
@@ -31,7 +32,7 @@ public:
   virtual void draw(sf::RenderWindow &window) const = 0;
   virtual size_t getNodeStatus() const = 0;
 
-  std::vector<std::shared_ptr<Node>> mChildren{};
+  std::vector<custom_classes::intrusive_ptr<Node>> mChildren{};
 
 protected:
   sf::Vector2f mPosition{0, 0};
@@ -44,7 +45,7 @@ protected:
 
 Node::Node(sf::Vector2f &position) : mPosition{position} {}
 
-void Node::addChild(const std::shared_ptr<Node> &child)
+void Node::addChild(const custom_classes::intrusive_ptr<Node> &child)
 {
   mChildren.push_back(child);
 }
@@ -204,7 +205,7 @@ public:
   }
 };
 
-std::shared_ptr<Node> anotherTree(const sf::Font &font);
+custom_classes::intrusive_ptr<Node> anotherTree(const sf::Font &font);
 
 AccumulateNode::AccumulateNode(sf::Vector2f &position, const sf::Font &font,
                                size_t max_level)
@@ -341,15 +342,15 @@ size_t AccumulateNode::getNodeStatus() const
   return sum + currentLevel;
 }
 
-std::shared_ptr<Node> anotherTree(const sf::Font &font)
+custom_classes::intrusive_ptr<Node> anotherTree(const sf::Font &font)
 {
-  std::shared_ptr<Node> root{new SwordRectSkillNode({400, 500}, font)};
+  custom_classes::intrusive_ptr<Node> root{new SwordRectSkillNode({400, 500}, font)};
   root->addChild(
-      std::shared_ptr<Node>{new SwordRectSkillNode({200, 400}, font)});
+      custom_classes::intrusive_ptr<Node>{new SwordRectSkillNode({200, 400}, font)});
   root->addChild(
-      std::shared_ptr<Node>{new FreezeRectSkillNode({400, 400}, font)});
+      custom_classes::intrusive_ptr<Node>{new FreezeRectSkillNode({400, 400}, font)});
   root->addChild(
-      std::shared_ptr<Node>{new ChainRectSkillNode({600, 400}, font)});
+      custom_classes::intrusive_ptr<Node>{new ChainRectSkillNode({600, 400}, font)});
   return root;
 }
 
@@ -375,7 +376,7 @@ private:
   bool mIsActivated = false;
 };
 
-std::shared_ptr<Node> createSkillTree();
+custom_classes::intrusive_ptr<Node> createSkillTree();
 
 class BombSkillNode : public HitNode
 {
@@ -594,28 +595,28 @@ size_t HitNode::getNodeStatus() const
   return (mState == State::Activated) ? sum + 1 : sum;
 }
 
-std::shared_ptr<Node> createSkillTree()
+custom_classes::intrusive_ptr<Node> createSkillTree()
 {
-  std::shared_ptr<Node> root{new LightningSkillNode({400, 500})};
-  std::shared_ptr<Node> a{new ShurikenSkillNode({200, 400})};
-  std::shared_ptr<Node> b{new BombSkillNode({400, 400})};
-  std::shared_ptr<Node> c{new EyeSkillNode({600, 400})};
+  custom_classes::intrusive_ptr<Node> root{new LightningSkillNode({400, 500})};
+  custom_classes::intrusive_ptr<Node> a{new ShurikenSkillNode({200, 400})};
+  custom_classes::intrusive_ptr<Node> b{new BombSkillNode({400, 400})};
+  custom_classes::intrusive_ptr<Node> c{new EyeSkillNode({600, 400})};
   root->addChild(a);
   root->addChild(b);
   root->addChild(c);
 
-  a->addChild(std::shared_ptr<Node>{new ShieldSkillNode({100, 200})});
-  a->addChild(std::shared_ptr<Node>{new SwordSkillNode({200, 200})});
-  a->addChild(std::shared_ptr<Node>{new EarthquakeSkillNode({300, 200})});
+  a->addChild(custom_classes::intrusive_ptr<Node>{new ShieldSkillNode({100, 200})});
+  a->addChild(custom_classes::intrusive_ptr<Node>{new SwordSkillNode({200, 200})});
+  a->addChild(custom_classes::intrusive_ptr<Node>{new EarthquakeSkillNode({300, 200})});
 
-  b->addChild(std::shared_ptr<Node>{new HandSkillNode({400, 200})});
-  b->addChild(std::shared_ptr<Node>{new MeteoriteSkillNode({500, 200})});
-  std::shared_ptr<Node> e{new BombSkillNode({600, 200})};
+  b->addChild(custom_classes::intrusive_ptr<Node>{new HandSkillNode({400, 200})});
+  b->addChild(custom_classes::intrusive_ptr<Node>{new MeteoriteSkillNode({500, 200})});
+  custom_classes::intrusive_ptr<Node> e{new BombSkillNode({600, 200})};
   b->addChild(e);
-  e->addChild(std::shared_ptr<Node>{new WindSkillNode({500, 100})});
-  e->addChild(std::shared_ptr<Node>{new SwordSkillNode({600, 100})});
-  c->addChild(std::shared_ptr<Node>{new EyeSkillNode({700, 200})});
-  std::shared_ptr<Node> f{new FireballSkillNode({100, 700})};
+  e->addChild(custom_classes::intrusive_ptr<Node>{new WindSkillNode({500, 100})});
+  e->addChild(custom_classes::intrusive_ptr<Node>{new SwordSkillNode({600, 100})});
+  c->addChild(custom_classes::intrusive_ptr<Node>{new EyeSkillNode({700, 200})});
+  custom_classes::intrusive_ptr<Node> f{new FireballSkillNode({100, 700})};
   a->addChild(f);
 
   return root;
@@ -624,14 +625,14 @@ std::shared_ptr<Node> createSkillTree()
 class AbstructSkillTree
 {
 public:
-  std::shared_ptr<Node> root;
+  custom_classes::intrusive_ptr<Node> root;
   sf::Text Title;
   std::string Name;
 
-  AbstructSkillTree(std::shared_ptr<Node> new_root, const sf::Font &font, const std::string title, size_t max_skill_points, sf::Color textColor);
+  AbstructSkillTree(custom_classes::intrusive_ptr<Node> new_root, const sf::Font &font, const std::string title, size_t max_skill_points, sf::Color textColor);
   void onMousePressed(sf::Vector2f mouseCoord, Node::MouseState state);
   void draw(sf::RenderWindow &window) const;
-  void addChild(const std::shared_ptr<Node> &child);
+  void addChild(const custom_classes::intrusive_ptr<Node> &child);
 
   static inline const sf::Vector2f title_offset{-25, 50};
   static inline const size_t kCharacterSize = 16;
@@ -643,16 +644,16 @@ public:
 class WarriorSkillTree : public AbstructSkillTree
 {
 public:
-  WarriorSkillTree(sf::Vector2f pos, const sf::Font &font) : AbstructSkillTree(std::shared_ptr<Node>{new SwordRectSkillNode{pos, font}}, font, std::string("Warrior\n"), 10, sf::Color{255, 255, 255})
-  {
-    addChild(std::shared_ptr<Node>{new SwordSkillNode({pos.x, pos.y - 100})});
-    root->mChildren[0]->addChild(std::shared_ptr<Node>{new EarthquakeSkillNode({pos.x - 50, pos.y - 150})});
-    root->mChildren[0]->addChild(std::shared_ptr<Node>{new SpikesSkillNode({pos.x + 50, pos.y - 150})});
-    root->mChildren[0]->addChild(std::shared_ptr<Node>{new BombSkillNode({pos.x, pos.y - 200})});
-    root->mChildren[0]->mChildren[2]->addChild(std::shared_ptr<Node>{new MeteoriteSkillNode({pos.x + 50, pos.y - 250})});
-    root->mChildren[0]->mChildren[2]->addChild(std::shared_ptr<Node>{new ShieldSkillNode({pos.x - 50, pos.y - 250})});
-    root->mChildren[0]->mChildren[2]->mChildren[0]->addChild(std::shared_ptr<Node>{new ClawsSkillNode({pos.x + 50, pos.y - 350})});
-    root->mChildren[0]->mChildren[2]->mChildren[1]->addChild(std::shared_ptr<Node>{new WindSkillNode({pos.x - 50, pos.y - 350})});
+  WarriorSkillTree(sf::Vector2f pos, const sf::Font &font) : AbstructSkillTree(custom_classes::intrusive_ptr<Node>{new SwordRectSkillNode{pos, font}}, font, std::string("Warrior\n"), 10, sf::Color{255, 255, 255})
+  {
+    addChild(custom_classes::intrusive_ptr<Node>{new SwordSkillNode({pos.x, pos.y - 100})});
+    root->mChildren[0]->addChild(custom_classes::intrusive_ptr<Node>{new EarthquakeSkillNode({pos.x - 50, pos.y - 150})});
+    root->mChildren[0]->addChild(custom_classes::intrusive_ptr<Node>{new SpikesSkillNode({pos.x + 50, pos.y - 150})});
+    root->mChildren[0]->addChild(custom_classes::intrusive_ptr<Node>{new BombSkillNode({pos.x, pos.y - 200})});
+    root->mChildren[0]->mChildren[2]->addChild(custom_classes::intrusive_ptr<Node>{new MeteoriteSkillNode({pos.x + 50, pos.y - 250})});
+    root->mChildren[0]->mChildren[2]->addChild(custom_classes::intrusive_ptr<Node>{new ShieldSkillNode({pos.x - 50, pos.y - 250})});
+    root->mChildren[0]->mChildren[2]->mChildren[0]->addChild(custom_classes::intrusive_ptr<Node>{new ClawsSkillNode({pos.x + 50, pos.y - 350})});
+    root->mChildren[0]->mChildren[2]->mChildren[1]->addChild(custom_classes::intrusive_ptr<Node>{new WindSkillNode({pos.x - 50, pos.y - 350})});
     root->unblock();
   }
 };
@@ -660,17 +661,17 @@ public:
 class RogueSkillTree : public AbstructSkillTree
 {
 public:
-  RogueSkillTree(sf::Vector2f pos, const sf::Font &font) : AbstructSkillTree(std::shared_ptr<Node>{new ChainRectSkillNode{pos, font}}, font, std::string("Rogue\n"), 10, sf::Color{255, 255, 255})
-  {
-    addChild(std::shared_ptr<Node>{new HandSkillNode({pos.x, pos.y - 100})});
-    root->mChildren[0]->addChild(std::shared_ptr<Node>{new SwordSkillNode({pos.x - 50, pos.y - 170})});
-    root->mChildren[0]->addChild(std::shared_ptr<Node>{new WindSkillNode({pos.x + 50, pos.y - 170})});
-    root->mChildren[0]->mChildren[0]->addChild(std::shared_ptr<Node>{new BombSkillNode({pos.x - 50, pos.y - 250})});
-    root->mChildren[0]->mChildren[1]->addChild(std::shared_ptr<Node>{new SpikesSkillNode({pos.x + 50, pos.y - 250})});
-    root->mChildren[0]->mChildren[1]->mChildren[0]->addChild(std::shared_ptr<Node>{new ClawsSkillNode({pos.x, pos.y - 350})});
-    root->mChildren[0]->mChildren[1]->mChildren[0]->addChild(std::shared_ptr<Node>{new MeteoriteSkillNode({pos.x + 50, pos.y - 320})});
-    root->mChildren[0]->mChildren[1]->mChildren[0]->addChild(std::shared_ptr<Node>{new EyeSkillNode({pos.x + 100, pos.y - 350})});
-    root->mChildren[0]->mChildren[0]->mChildren[0]->addChild(std::shared_ptr<Node>{new EarthquakeSkillNode({pos.x - 50, pos.y - 320})});
+  RogueSkillTree(sf::Vector2f pos, const sf::Font &font) : AbstructSkillTree(custom_classes::intrusive_ptr<Node>{new ChainRectSkillNode{pos, font}}, font, std::string("Rogue\n"), 10, sf::Color{255, 255, 255})
+  {
+    addChild(custom_classes::intrusive_ptr<Node>{new HandSkillNode({pos.x, pos.y - 100})});
+    root->mChildren[0]->addChild(custom_classes::intrusive_ptr<Node>{new SwordSkillNode({pos.x - 50, pos.y - 170})});
+    root->mChildren[0]->addChild(custom_classes::intrusive_ptr<Node>{new WindSkillNode({pos.x + 50, pos.y - 170})});
+    root->mChildren[0]->mChildren[0]->addChild(custom_classes::intrusive_ptr<Node>{new BombSkillNode({pos.x - 50, pos.y - 250})});
+    root->mChildren[0]->mChildren[1]->addChild(custom_classes::intrusive_ptr<Node>{new SpikesSkillNode({pos.x + 50, pos.y - 250})});
+    root->mChildren[0]->mChildren[1]->mChildren[0]->addChild(custom_classes::intrusive_ptr<Node>{new ClawsSkillNode({pos.x, pos.y - 350})});
+    root->mChildren[0]->mChildren[1]->mChildren[0]->addChild(custom_classes::intrusive_ptr<Node>{new MeteoriteSkillNode({pos.x + 50, pos.y - 320})});
+    root->mChildren[0]->mChildren[1]->mChildren[0]->addChild(custom_classes::intrusive_ptr<Node>{new EyeSkillNode({pos.x + 100, pos.y - 350})});
+    root->mChildren[0]->mChildren[0]->mChildren[0]->addChild(custom_classes::intrusive_ptr<Node>{new EarthquakeSkillNode({pos.x - 50, pos.y - 320})});
     root->unblock();
   }
 };
@@ -678,20 +679,20 @@ public:
 class MageSkillTree : public AbstructSkillTree
 {
 public:
-  MageSkillTree(sf::Vector2f pos, const sf::Font &font) : AbstructSkillTree(std::shared_ptr<Node>{new FreezeRectSkillNode{pos, font}}, font, std::string("Mage\n"), 10, sf::Color{255, 255, 255})
-  {
-    addChild(std::shared_ptr<Node>{new EyeSkillNode({pos.x, pos.y - 100})});
-    root->mChildren[0]->addChild(std::shared_ptr<Node>{new LightningSkillNode({pos.x - 50, pos.y - 200})});
-    root->mChildren[0]->addChild(std::shared_ptr<Node>{new WindSkillNode({pos.x + 50, pos.y - 200})});
-    root->mChildren[0]->mChildren[0]->addChild(std::shared_ptr<Node>{new HandSkillNode({pos.x - 100, pos.y - 300})});
-    root->mChildren[0]->mChildren[1]->addChild(std::shared_ptr<Node>{new MeteoriteSkillNode({pos.x + 50, pos.y - 350})});
-    root->mChildren[0]->mChildren[0]->addChild(std::shared_ptr<Node>{new ClawsSkillNode({pos.x - 50, pos.y - 350})});
-    root->mChildren[0]->mChildren[0]->addChild(std::shared_ptr<Node>{new EarthquakeSkillNode({pos.x, pos.y - 300})});
+  MageSkillTree(sf::Vector2f pos, const sf::Font &font) : AbstructSkillTree(custom_classes::intrusive_ptr<Node>{new FreezeRectSkillNode{pos, font}}, font, std::string("Mage\n"), 10, sf::Color{255, 255, 255})
+  {
+    addChild(custom_classes::intrusive_ptr<Node>{new EyeSkillNode({pos.x, pos.y - 100})});
+    root->mChildren[0]->addChild(custom_classes::intrusive_ptr<Node>{new LightningSkillNode({pos.x - 50, pos.y - 200})});
+    root->mChildren[0]->addChild(custom_classes::intrusive_ptr<Node>{new WindSkillNode({pos.x + 50, pos.y - 200})});
+    root->mChildren[0]->mChildren[0]->addChild(custom_classes::intrusive_ptr<Node>{new HandSkillNode({pos.x - 100, pos.y - 300})});
+    root->mChildren[0]->mChildren[1]->addChild(custom_classes::intrusive_ptr<Node>{new MeteoriteSkillNode({pos.x + 50, pos.y - 350})});
+    root->mChildren[0]->mChildren[0]->addChild(custom_classes::intrusive_ptr<Node>{new ClawsSkillNode({pos.x - 50, pos.y - 350})});
+    root->mChildren[0]->mChildren[0]->addChild(custom_classes::intrusive_ptr<Node>{new EarthquakeSkillNode({pos.x, pos.y - 300})});
     root->unblock();
   }
 };
 
-AbstructSkillTree::AbstructSkillTree(std::shared_ptr<Node> new_root, const sf::Font &font, const std::string s_title, size_t max_skill_points, sf::Color textColor)
+AbstructSkillTree::AbstructSkillTree(custom_classes::intrusive_ptr<Node> new_root, const sf::Font &font, const std::string s_title, size_t max_skill_points, sf::Color textColor)
 {
   maxPoints = max_skill_points;
   Name = s_title;
@@ -736,7 +737,7 @@ void AbstructSkillTree::draw(sf::RenderWindow &window) const
   window.draw(Title);
 }
 
-void AbstructSkillTree::addChild(const std::shared_ptr<Node> &child)
+void AbstructSkillTree::addChild(const custom_classes::intrusive_ptr<Node> &child)
 {
   root->addChild(child);
 }
@@ -1,4 +1,10 @@
+#pragma once
 #include <iostream>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "instrumentation.cpp"
 
 namespace custom_classes
 {
@@ -14,54 +20,203 @@ namespace custom_classes
         void operator()(data_t *ptr) noexcept { delete[] ptr; }
     };
 
+    namespace detail
+    {
+        // Holds a deleter or an allocator. An empty type becomes a base
+        // class, so it takes no space and a unique_ptr with a stateless
+        // deleter is as big as a raw pointer.
+        template <typename data_t,
+                  bool = std::is_empty<data_t>::value && !std::is_final<data_t>::value>
+        struct ebo_storage : private data_t
+        {
+            ebo_storage() = default;
+            ebo_storage(data_t value) noexcept : data_t(std::move(value)) {}
+
+            data_t &value() noexcept { return *this; }
+            const data_t &value() const noexcept { return *this; }
+        };
+
+        template <typename data_t>
+        struct ebo_storage<data_t, false>
+        {
+            ebo_storage() = default;
+            ebo_storage(data_t value) noexcept : value_(std::move(value)) {}
+
+            data_t &value() noexcept { return value_; }
+            const data_t &value() const noexcept { return value_; }
+
+        private:
+            data_t value_;
+        };
+    }
+
     template <typename data_t, typename Deleter = default_delete<data_t>>
-    struct unique_ptr
+    struct unique_ptr : private detail::ebo_storage<Deleter>
     {
     private:
+        using storage = detail::ebo_storage<Deleter>;
+
         data_t *ptr_;
-        Deleter del_;
 
     public:
-        unique_ptr(data_t *ptr = nullptr) noexcept : ptr_(ptr) {}
+        CUSTOM_CLASSES_ENTRY unique_ptr(data_t *ptr = nullptr) noexcept : ptr_(ptr)
+        {
+            if (ptr_ != nullptr)
+                instrumentation::track_adopt<data_t>(CUSTOM_CLASSES_CALLER);
+        }
+        CUSTOM_CLASSES_ENTRY unique_ptr(data_t *ptr, Deleter del) noexcept
+            : storage(std::move(del)), ptr_(ptr)
+        {
+            if (ptr_ != nullptr)
+                instrumentation::track_adopt<data_t>(CUSTOM_CLASSES_CALLER);
+        }
         unique_ptr(const unique_ptr &other) = delete;
         unique_ptr &operator=(const unique_ptr &other) = delete;
-        unique_ptr(unique_ptr &&other) noexcept : ptr_(other.ptr_)
+        unique_ptr(unique_ptr &&other) noexcept : storage(std::move(other.get_deleter())),
+                                                  ptr_(other.ptr_)
         {
             other.ptr_ = nullptr;
         }
         unique_ptr &operator=(unique_ptr &&other) noexcept
         {
             std::swap(ptr_, other.ptr_);
+            std::swap(get_deleter(), other.get_deleter());
             return *this;
         }
-        ~unique_ptr() { del_(ptr_); }
-        data_t *operator->() { return ptr_; }
-        data_t &operator*() { return *(ptr_); }
+        ~unique_ptr() { reset(); }
+
+        data_t *release() noexcept
+        {
+            if (ptr_ != nullptr)
+                instrumentation::track_free<data_t>();
+            return std::exchange(ptr_, nullptr);
+        }
+        CUSTOM_CLASSES_ENTRY void reset(data_t *ptr = nullptr) noexcept
+        {
+            if (ptr != nullptr)
+                instrumentation::track_adopt<data_t>(CUSTOM_CLASSES_CALLER);
+            data_t *old = std::exchange(ptr_, ptr);
+            if (old != nullptr)
+            {
+                instrumentation::track_free<data_t>();
+                get_deleter()(old);
+            }
+        }
+
+        Deleter &get_deleter() noexcept { return storage::value(); }
+        const Deleter &get_deleter() const noexcept { return storage::value(); }
+
+        data_t *get() const noexcept { return ptr_; }
+        data_t *operator->() const noexcept { return ptr_; }
+        data_t &operator*() const noexcept { return *(ptr_); }
     };
 
     template <typename data_t, typename Deleter>
-    struct unique_ptr<data_t[], Deleter>
+    struct unique_ptr<data_t[], Deleter> : private detail::ebo_storage<Deleter>
     {
     private:
+        using storage = detail::ebo_storage<Deleter>;
+
         data_t *ptr_;
-        Deleter del_;
 
     public:
-        unique_ptr(data_t *ptr = nullptr) noexcept : ptr_(ptr) {}
+        CUSTOM_CLASSES_ENTRY unique_ptr(data_t *ptr = nullptr) noexcept : ptr_(ptr)
+        {
+            if (ptr_ != nullptr)
+                instrumentation::track_adopt<data_t>(CUSTOM_CLASSES_CALLER);
+        }
+        CUSTOM_CLASSES_ENTRY unique_ptr(data_t *ptr, Deleter del) noexcept
+            : storage(std::move(del)), ptr_(ptr)
+        {
+            if (ptr_ != nullptr)
+                instrumentation::track_adopt<data_t>(CUSTOM_CLASSES_CALLER);
+        }
         unique_ptr(const unique_ptr &other) = delete;
         unique_ptr &operator=(const unique_ptr &other) = delete;
-        unique_ptr(unique_ptr &&other) noexcept : ptr_(other.ptr_)
+        unique_ptr(unique_ptr &&other) noexcept : storage(std::move(other.get_deleter())),
+                                                  ptr_(other.ptr_)
         {
             other.ptr_ = nullptr;
         }
         unique_ptr &operator=(unique_ptr &&other) noexcept
         {
             std::swap(ptr_, other.ptr_);
+            std::swap(get_deleter(), other.get_deleter());
             return *this;
         }
-        ~unique_ptr() { del_(ptr_); }
-        data_t *operator->() { return ptr_; }
-        data_t &operator*() { return *(ptr_); }
-        data_t &operator[](const size_t num) { return *(ptr_ + num); }
+        ~unique_ptr() { reset(); }
+
+        data_t *release() noexcept
+        {
+            if (ptr_ != nullptr)
+                instrumentation::track_free<data_t>();
+            return std::exchange(ptr_, nullptr);
+        }
+        CUSTOM_CLASSES_ENTRY void reset(data_t *ptr = nullptr) noexcept
+        {
+            if (ptr != nullptr)
+                instrumentation::track_adopt<data_t>(CUSTOM_CLASSES_CALLER);
+            data_t *old = std::exchange(ptr_, ptr);
+            if (old != nullptr)
+            {
+                instrumentation::track_free<data_t>();
+                get_deleter()(old);
+            }
+        }
+
+        Deleter &get_deleter() noexcept { return storage::value(); }
+        const Deleter &get_deleter() const noexcept { return storage::value(); }
+
+        data_t *get() const noexcept { return ptr_; }
+        data_t *operator->() const noexcept { return ptr_; }
+        data_t &operator*() const noexcept { return *(ptr_); }
+        data_t &operator[](const size_t num) const { return *(ptr_ + num); }
+    };
+
+    static_assert(sizeof(unique_ptr<int>) == sizeof(int *),
+                  "empty deleters must not make unique_ptr bigger than a pointer");
+    static_assert(sizeof(unique_ptr<int[]>) == sizeof(int *),
+                  "empty deleters must not make unique_ptr bigger than a pointer");
+
+    // Deleter for objects created by allocate_unique: destroys the object and
+    // hands the memory back to the allocator it came from.
+    template <typename Alloc>
+    struct allocator_delete : private detail::ebo_storage<Alloc>
+    {
+        using traits = std::allocator_traits<Alloc>;
+
+        allocator_delete(const Alloc &alloc = Alloc()) : detail::ebo_storage<Alloc>(alloc) {}
+
+        void operator()(typename traits::pointer ptr) noexcept
+        {
+            if (ptr == nullptr)
+                return;
+            traits::destroy(this->value(), ptr);
+            traits::deallocate(this->value(), ptr, 1);
+        }
     };
+
+    static_assert(sizeof(unique_ptr<int, allocator_delete<std::allocator<int>>>) == sizeof(int *),
+                  "stateless allocators must not make unique_ptr bigger than a pointer");
+
+    template <typename data_t, typename Alloc, typename... Args>
+    auto allocate_unique(const Alloc &alloc, Args &&...args)
+    {
+        using allocator_type = typename std::allocator_traits<Alloc>::template rebind_alloc<data_t>;
+        using traits = std::allocator_traits<allocator_type>;
+
+        allocator_type data_alloc(alloc);
+        data_t *ptr = traits::allocate(data_alloc, 1);
+        try
+        {
+            traits::construct(data_alloc, ptr, std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            traits::deallocate(data_alloc, ptr, 1);
+            throw;
+        }
+        return unique_ptr<data_t, allocator_delete<allocator_type>>(
+            ptr, allocator_delete<allocator_type>(data_alloc));
+    }
 }